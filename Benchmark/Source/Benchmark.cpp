@@ -0,0 +1,260 @@
+#include "Benchmark.h"
+#include "Memory.h"
+#include "Core/Huffman.h"
+#include "Core/Registry.h"
+#include "Core/ThreadPool.h"
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+namespace Benchmark
+{
+	/**< Seed of the synthetic data, fixed so every commit benchmarks the same inputs. */
+	static constexpr std::uint64_t kSeed = 0x5069'7374'6f6e'6521;
+
+	static double SecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	static Core::MethodOptions Options(const Settings& settings)
+	{
+		Core::MethodOptions options;
+		options.blockSize = settings.blockSize;
+		options.threadCount = settings.threadCount;
+		return options;
+	}
+
+	std::vector<MethodEntry> Methods()
+	{
+		std::vector<MethodEntry> methods;
+		for (const Core::MethodInfo& method : Core::RegisteredMethods())
+		{
+			methods.push_back({ method.name, [create = method.create](const Settings& settings) { return create(Options(settings)); } });
+
+			if (method.name == "huf")
+			{
+				methods.push_back({ "huf-x1", [](const Settings& settings) -> std::unique_ptr<Core::CompressionMethod>
+					{ return std::make_unique<Huffman::HuffmanCompression>(settings.blockSize, settings.threadCount, Core::kDefaultMemoryBudget,
+						Huffman::kDefaultCodeLengthLimit, false); } });
+			}
+		}
+		return methods;
+	}
+
+	Result Measure(const CorpusItem& item, const MethodEntry& entry, const Settings& settings)
+	{
+		Result result{ item.name, item.kind, entry.name, item.data.size(), 0, {}, {}, 0, 0, true };
+		std::unique_ptr<Core::CompressionMethod> method = entry.create(settings);
+		auto input = std::as_bytes(std::span<const char>(item.data));
+
+		std::vector<std::byte> encoded;
+		{
+			std::size_t baseline = CurrentHeapBytes();
+			ResetPeakHeapBytes();
+
+			std::unique_ptr<Core::EncoderContext> encoder = method->createEncoder();
+			encoded.resize(method->compressBound(item.data.size()));
+
+			for (unsigned run = 0; run < settings.warmups + settings.runs; run++)
+			{
+				auto start = std::chrono::steady_clock::now();
+				result.encodedSize = encoder->encode(input, encoded);
+				double seconds = SecondsSince(start);
+				if (run >= settings.warmups) result.encodeSeconds.push_back(seconds);
+			}
+
+			result.encodePeakBytes = PeakHeapBytes() - baseline;
+		}
+		encoded.resize(result.encodedSize);
+		encoded.shrink_to_fit();
+
+		std::size_t baseline = CurrentHeapBytes();
+		ResetPeakHeapBytes();
+
+		std::unique_ptr<Core::DecoderContext> decoder = method->createDecoder();
+		std::vector<std::byte> decoded(decoder->decodedSize(encoded));
+		result.verified = decoded.size() == item.data.size();
+
+		for (unsigned run = 0; run < settings.warmups + settings.runs && result.verified; run++)
+		{
+			std::memset(decoded.data(), 0, decoded.size());
+
+			auto start = std::chrono::steady_clock::now();
+			std::size_t decodedSize = decoder->decode(encoded, decoded);
+			double seconds = SecondsSince(start);
+			if (run >= settings.warmups) result.decodeSeconds.push_back(seconds);
+
+			result.verified = decodedSize == item.data.size() && std::memcmp(decoded.data(), item.data.data(), decodedSize) == 0;
+		}
+
+		result.decodePeakBytes = PeakHeapBytes() - baseline;
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	using namespace Benchmark;
+
+	String corpusPath = "";
+	String outFilePath = "";
+	String format = "table";
+	std::size_t maxSyntheticSize = kDefaultSyntheticSize;
+	std::vector<String> methodNames;
+	Settings settings{ 5, 1, 1, Core::kDefaultBlockSize };
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (argv[i][0] != '-') continue;
+
+		bool hasValue = i < argc - 1;
+		switch (argv[i][1])
+		{
+			case 'c':
+				if (hasValue) corpusPath = argv[++i];
+				break;
+
+			case 'o':
+				if (hasValue) outFilePath = argv[++i];
+				break;
+
+			case 'f':
+				if (hasValue) format = argv[++i];
+				if (format != "table" && format != "csv" && format != "json")
+				{
+					std::cout << "Unknown report format: " << format << std::endl;
+					return 1;
+				}
+				break;
+
+			case 'm':
+				if (hasValue) methodNames.push_back(argv[++i]);
+				break;
+
+			case 's':
+				if (hasValue)
+				{
+					maxSyntheticSize = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024;
+					if (maxSyntheticSize > kMaxSyntheticSize)
+					{
+						std::cout << "Invalid synthetic size, expected at most 1048576 KiB." << std::endl;
+						return 1;
+					}
+				}
+				break;
+
+			case 'r':
+				if (hasValue)
+				{
+					settings.runs = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+					if (settings.runs == 0) settings.runs = 1;
+				}
+				break;
+
+			case 'w':
+				if (hasValue) settings.warmups = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+				break;
+
+			case 't':
+				if (hasValue)
+				{
+					settings.threadCount = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+					if (settings.threadCount == 0) settings.threadCount = Core::ThreadPool::hardwareThreads();
+				}
+				break;
+
+			case 'b':
+				if (hasValue)
+				{
+					settings.blockSize = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024;
+					if (settings.blockSize == 0) settings.blockSize = Core::kDefaultBlockSize;
+				}
+				break;
+
+			case 'h':
+				PRINT_HELP;
+				return 0;
+
+			default:
+				break;
+		}
+	}
+
+	std::vector<MethodEntry> methods;
+	for (const MethodEntry& entry : Methods())
+	{
+		if (methodNames.empty() || std::find(methodNames.begin(), methodNames.end(), entry.name) != methodNames.end()) methods.push_back(entry);
+	}
+	if (methods.empty())
+	{
+		std::cout << "No compression method matches -m." << std::endl;
+		return 1;
+	}
+
+	if (corpusPath == "") corpusPath = fs::is_directory("Tests") ? "Tests" : "../Tests";
+
+	std::ofstream outFile;
+	if (outFilePath != "")
+	{
+		outFile.open(outFilePath, std::ios::binary);
+		if (!outFile)
+		{
+			std::cout << "Error opening file: " << outFilePath << std::endl;
+			return 1;
+		}
+	}
+
+	// The table doubles as progress output, it moves to stderr when the report takes stdout.
+	std::ostream& report = outFilePath != "" ? static_cast<std::ostream&>(outFile) : std::cout;
+	std::ostream& progress = format != "table" && outFilePath == "" ? std::cerr : std::cout;
+
+	std::vector<Result> results;
+	auto run = [&](const CorpusItem& item)
+	{
+		for (const MethodEntry& method : methods)
+		{
+			results.push_back(Measure(item, method, settings));
+			PrintTableRow(progress, results.back());
+		}
+	};
+
+	try
+	{
+		PrintTableHeader(progress);
+
+		for (const fs::path& file : ListFiles(corpusPath))
+		{
+			run(LoadFile(corpusPath, file));
+		}
+
+		if (maxSyntheticSize >= kMinSyntheticSize)
+		{
+			for (const char* kind : kSyntheticKinds)
+			{
+				for (std::size_t size : SyntheticSizes(kMinSyntheticSize, maxSyntheticSize))
+				{
+					run(Generate(kind, size, kSeed));
+				}
+			}
+		}
+	}
+	catch (const Core::CompressionException& error)
+	{
+		std::cout << error.what() << std::endl;
+		return 1;
+	}
+
+	if (format == "csv") WriteCsv(report, results);
+	else if (format == "json") WriteJson(report, settings, results);
+	else if (outFilePath != "")
+	{
+		PrintTableHeader(report);
+		for (const Result& result : results) PrintTableRow(report, result);
+	}
+
+	bool verified = std::all_of(results.begin(), results.end(), [](const Result& result) { return result.verified; });
+	return verified ? 0 : 2;
+}
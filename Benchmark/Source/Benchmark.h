@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core/Core.h"
+#include "Corpus.h"
+#include "Report.h"
+#include <functional>
+
+#define PRINT_HELP std::cout << "-c <corpus_path> folder of files to benchmark (default Tests)" << std::endl;\
+std::cout << "-s <size> largest synthetic input in KiB, 0 disables synthetic data (default 16384, up to 1048576)" << std::endl;\
+std::cout << "-m <method> benchmark only the given method, may be repeated" << std::endl;\
+std::cout << "-r <runs> measured runs per input and method (default 5)" << std::endl;\
+std::cout << "-w <runs> warm-up runs per input and method (default 1)" << std::endl;\
+std::cout << "-t <threads> number of compression threads, 0 uses all cores (default 1)" << std::endl;\
+std::cout << "-b <block_size> block size in KiB for multithreaded compression (default 1024)" << std::endl;\
+std::cout << "-f <format> report format: \"table\" (default), \"csv\", \"json\"" << std::endl;\
+std::cout << "-o <output_path> write the report to a file instead of the standard output" << std::endl
+
+namespace Benchmark
+{
+	/**
+	* @brief Smallest synthetic input.
+	*/
+	constexpr std::size_t kMinSyntheticSize = 1024;
+
+	/**
+	* @brief Default largest synthetic input.
+	*/
+	constexpr std::size_t kDefaultSyntheticSize = std::size_t(16) << 20;
+
+	/**
+	* @brief Largest synthetic input accepted by -s.
+	*/
+	constexpr std::size_t kMaxSyntheticSize = std::size_t(1) << 30;
+
+	/**
+	* @brief A benchmarked compression method.
+	*/
+	struct MethodEntry
+	{
+		/**< Name used by -m and in the reports. */
+		String name;
+
+		/**< Constructs the method with the benchmark's thread count and block size. */
+		std::function<std::unique_ptr<Core::CompressionMethod>(const Settings&)> create;
+	};
+
+	/**
+	* @brief Returns every registered method, and huf-x1, huf decoding one symbol per lookup.
+	*/
+	std::vector<MethodEntry> Methods();
+
+	/**
+	* @brief Measures one method on one input.
+	*
+	* Runs settings.warmups unmeasured round trips, then settings.runs measured ones through
+	* a reused encoder and decoder. Each run's decoded output is compared with the input.
+	*
+	* @throw Core::CompressionException if the method fails on the input.
+	*/
+	Result Measure(const CorpusItem& item, const MethodEntry& method, const Settings& settings);
+}
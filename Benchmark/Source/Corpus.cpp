@@ -0,0 +1,153 @@
+#include "Corpus.h"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace Benchmark
+{
+	static constexpr std::size_t kRecordSize = 4096;
+
+	static constexpr std::size_t kMutationsPerRecord = 40;
+
+	static constexpr std::size_t kVocabularySize = 512;
+
+	static void GenerateRandom(std::vector<char>& data, std::mt19937_64& random)
+	{
+		std::size_t i = 0;
+		for (; i + 8 <= data.size(); i += 8)
+		{
+			std::uint64_t value = random();
+			std::memcpy(data.data() + i, &value, 8);
+		}
+		for (; i < data.size(); i++) data[i] = static_cast<char>(random());
+	}
+
+	static void GenerateSkewed(std::vector<char>& data, std::mt19937_64& random)
+	{
+		// Inverse CDF of a geometric distribution, indexed by 12 random bits.
+		constexpr double p = 0.25;
+		std::uint8_t table[4096];
+		for (int i = 0; i < 4096; i++)
+		{
+			double u = (i + 0.5) / 4096.0;
+			table[i] = static_cast<std::uint8_t>(std::min(255.0, std::floor(std::log(1.0 - u) / std::log(1.0 - p))));
+		}
+
+		std::size_t i = 0;
+		while (i < data.size())
+		{
+			std::uint64_t value = random();
+			for (int k = 0; k < 5 && i < data.size(); k++, value >>= 12) data[i++] = static_cast<char>(table[value & 4095]);
+		}
+	}
+
+	static void GenerateText(std::vector<char>& data, std::mt19937_64& random)
+	{
+		std::vector<String> vocabulary(kVocabularySize);
+		for (String& word : vocabulary)
+		{
+			std::size_t length = 2 + random() % 9;
+			for (std::size_t i = 0; i < length; i++) word.push_back(static_cast<char>('a' + random() % 26));
+		}
+
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		const double logSize = std::log(static_cast<double>(kVocabularySize));
+
+		std::size_t i = 0;
+		std::size_t lineLength = 0;
+		while (i < data.size())
+		{
+			// A log-uniform rank gives the Zipf-like word frequencies of natural text.
+			std::size_t rank = static_cast<std::size_t>(std::exp(uniform(random) * logSize)) - 1;
+			const String& word = vocabulary[std::min(rank, kVocabularySize - 1)];
+			for (std::size_t k = 0; k < word.size() && i < data.size(); k++) data[i++] = word[k];
+
+			lineLength += word.size() + 1;
+			if (i < data.size()) data[i++] = random() % 12 == 0 ? '.' : ' ';
+			if (lineLength > 80 && i < data.size())
+			{
+				data[i++] = '\n';
+				lineLength = 0;
+			}
+		}
+	}
+
+	static void GenerateRepetitive(std::vector<char>& data, std::mt19937_64& random)
+	{
+		std::vector<char> record(kRecordSize);
+		GenerateText(record, random);
+
+		for (std::size_t offset = 0; offset < data.size(); offset += kRecordSize)
+		{
+			std::size_t size = std::min(kRecordSize, data.size() - offset);
+			for (std::size_t k = 0; k < kMutationsPerRecord; k++) record[random() % kRecordSize] = static_cast<char>(random());
+			std::memcpy(data.data() + offset, record.data(), size);
+		}
+	}
+
+	std::vector<fs::path> ListFiles(const fs::path& directory)
+	{
+		std::vector<fs::path> files;
+		if (!fs::is_directory(directory)) return files;
+
+		for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory))
+		{
+			if (entry.is_regular_file()) files.push_back(entry.path());
+		}
+
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+
+	CorpusItem LoadFile(const fs::path& directory, const fs::path& file)
+	{
+		CorpusItem item{ fs::relative(file, directory).generic_string(), "file", {} };
+
+		std::ifstream input(file, std::ios::binary);
+		if (!input) throw Core::CompressionException("Error opening file: " + file.string());
+
+		item.data.resize(static_cast<std::size_t>(fs::file_size(file)));
+		input.read(item.data.data(), item.data.size());
+		if (!input) throw Core::CompressionException("Error reading file: " + file.string());
+
+		return item;
+	}
+
+	std::vector<std::size_t> SyntheticSizes(std::size_t minSize, std::size_t maxSize)
+	{
+		std::vector<std::size_t> sizes;
+		for (std::size_t size = minSize; size <= maxSize; size *= 16)
+		{
+			sizes.push_back(size);
+			if (size > maxSize / 16) break;
+		}
+		return sizes;
+	}
+
+	CorpusItem Generate(const String& kind, std::size_t size, std::uint64_t seed)
+	{
+		CorpusItem item{ kind + "-" + FormatSize(size), kind, std::vector<char>(size) };
+		std::mt19937_64 random(seed);
+
+		if (kind == "random") GenerateRandom(item.data, random);
+		else if (kind == "skewed") GenerateSkewed(item.data, random);
+		else if (kind == "repetitive") GenerateRepetitive(item.data, random);
+		else if (kind == "text") GenerateText(item.data, random);
+		else throw std::invalid_argument("Unknown synthetic data kind: " + kind);
+
+		return item;
+	}
+
+	String FormatSize(std::size_t size)
+	{
+		const char* units[] = { "B", "KiB", "MiB", "GiB" };
+		int unit = 0;
+		while (unit < 3 && size >= 1024 && size % 1024 == 0)
+		{
+			size /= 1024;
+			unit++;
+		}
+		return std::to_string(size) + units[unit];
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Core/Core.h"
+
+namespace Benchmark
+{
+	/**
+	* @brief Kinds of synthetic data produced by Generate.
+	*
+	* - random: uniformly distributed bytes
+	* - skewed: geometrically distributed bytes, like counters and telemetry
+	* - repetitive: a record repeated with a few mutated bytes, like logs and tables
+	* - text: words of a small vocabulary with a Zipf-like frequency
+	*/
+	constexpr const char* kSyntheticKinds[] = { "random", "skewed", "repetitive", "text" };
+
+	/**
+	* @brief One input of the benchmark.
+	*/
+	struct CorpusItem
+	{
+		/**< File path relative to the corpus directory, or the synthetic kind and size. */
+		String name;
+
+		/**< "file" or one of kSyntheticKinds. */
+		String kind;
+
+		std::vector<char> data;
+	};
+
+	/**
+	* @brief Lists the regular files under a directory, recursively and sorted.
+	*/
+	std::vector<fs::path> ListFiles(const fs::path& directory);
+
+	/**
+	* @brief Reads a file of the corpus.
+	*
+	* @param directory The corpus directory, names are relative to it.
+	* @param file Path of the file.
+	*/
+	CorpusItem LoadFile(const fs::path& directory, const fs::path& file);
+
+	/**
+	* @brief Returns the synthetic sizes from minSize to maxSize, each 16 times the previous one.
+	*/
+	std::vector<std::size_t> SyntheticSizes(std::size_t minSize, std::size_t maxSize);
+
+	/**
+	* @brief Generates size bytes of synthetic data, the same seed always gives the same data.
+	*
+	* @param kind One of kSyntheticKinds.
+	* @param size The size of the data.
+	* @param seed Seed of the generator.
+	*
+	* @throw std::invalid_argument if the kind is unknown.
+	*/
+	CorpusItem Generate(const String& kind, std::size_t size, std::uint64_t seed);
+
+	/**
+	* @brief Formats a size with a binary unit, e.g. 64KiB.
+	*/
+	String FormatSize(std::size_t size);
+}
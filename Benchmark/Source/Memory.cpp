@@ -0,0 +1,104 @@
+#include "Memory.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace Benchmark
+{
+	/**< Bytes in front of every allocation holding its size, keeps the alignment of malloc. */
+	static constexpr std::size_t kHeaderSize = alignof(std::max_align_t);
+
+	static std::atomic<std::size_t> currentBytes{ 0 };
+
+	static std::atomic<std::size_t> peakBytes{ 0 };
+
+	static void* Allocate(std::size_t size)
+	{
+		void* block = std::malloc(size + kHeaderSize);
+		if (!block) return nullptr;
+
+		*static_cast<std::size_t*>(block) = size;
+		std::size_t current = currentBytes.fetch_add(size, std::memory_order_relaxed) + size;
+		std::size_t peak = peakBytes.load(std::memory_order_relaxed);
+		while (current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+
+		return static_cast<char*>(block) + kHeaderSize;
+	}
+
+	static void Release(void* pointer)
+	{
+		if (!pointer) return;
+
+		void* block = static_cast<char*>(pointer) - kHeaderSize;
+		currentBytes.fetch_sub(*static_cast<std::size_t*>(block), std::memory_order_relaxed);
+		std::free(block);
+	}
+
+	std::size_t CurrentHeapBytes()
+	{
+		return currentBytes.load(std::memory_order_relaxed);
+	}
+
+	std::size_t PeakHeapBytes()
+	{
+		return peakBytes.load(std::memory_order_relaxed);
+	}
+
+	void ResetPeakHeapBytes()
+	{
+		peakBytes.store(currentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	void* pointer = Benchmark::Allocate(size);
+	if (!pointer) throw std::bad_alloc();
+	return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Benchmark::Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return Benchmark::Allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	Benchmark::Release(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	Benchmark::Release(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	Benchmark::Release(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+	Benchmark::Release(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	Benchmark::Release(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	Benchmark::Release(pointer);
+}
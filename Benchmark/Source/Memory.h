@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Benchmark
+{
+	/**
+	* @brief Returns the bytes currently allocated through the global operator new.
+	*/
+	std::size_t CurrentHeapBytes();
+
+	/**
+	* @brief Returns the highest value of CurrentHeapBytes since the last ResetPeakHeapBytes.
+	*/
+	std::size_t PeakHeapBytes();
+
+	/**
+	* @brief Starts a new peak measurement from the current heap usage.
+	*/
+	void ResetPeakHeapBytes();
+}
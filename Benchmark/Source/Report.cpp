@@ -0,0 +1,136 @@
+#include "Report.h"
+
+#include <iomanip>
+
+namespace Benchmark
+{
+	static String EscapeJson(const String& text)
+	{
+		String escaped;
+		for (char c : text)
+		{
+			switch (c)
+			{
+				case '"': escaped += "\\\""; break;
+				case '\\': escaped += "\\\\"; break;
+				case '\n': escaped += "\\n"; break;
+				case '\t': escaped += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20)
+					{
+						char code[8];
+						std::snprintf(code, sizeof(code), "\\u%04x", c);
+						escaped += code;
+					}
+					else
+					{
+						escaped += c;
+					}
+			}
+		}
+		return escaped;
+	}
+
+	static String EscapeCsv(const String& text)
+	{
+		if (text.find_first_of(",\"\n") == String::npos) return text;
+
+		String escaped = "\"";
+		for (char c : text)
+		{
+			if (c == '"') escaped += '"';
+			escaped += c;
+		}
+		return escaped + "\"";
+	}
+
+	static double Ratio(const Result& result)
+	{
+		return result.encodedSize == 0 ? 0.0 : static_cast<double>(result.size) / static_cast<double>(result.encodedSize);
+	}
+
+	double Median(std::vector<double> seconds)
+	{
+		if (seconds.empty()) return 0.0;
+
+		std::sort(seconds.begin(), seconds.end());
+		std::size_t middle = seconds.size() / 2;
+		return seconds.size() % 2 ? seconds[middle] : (seconds[middle - 1] + seconds[middle]) / 2;
+	}
+
+	double Throughput(std::size_t size, double seconds)
+	{
+		return seconds > 0 ? static_cast<double>(size) / seconds / 1e6 : 0.0;
+	}
+
+	void PrintTableHeader(std::ostream& output)
+	{
+		output << std::left << std::setw(44) << "input" << std::setw(10) << "method" << std::right
+			<< std::setw(12) << "size" << std::setw(12) << "encoded" << std::setw(8) << "ratio"
+			<< std::setw(11) << "enc MB/s" << std::setw(11) << "dec MB/s"
+			<< std::setw(12) << "enc peak" << std::setw(12) << "dec peak" << std::endl;
+	}
+
+	void PrintTableRow(std::ostream& output, const Result& result)
+	{
+		output << std::left << std::setw(44) << result.input << std::setw(10) << result.method << std::right
+			<< std::setw(12) << result.size << std::setw(12) << result.encodedSize
+			<< std::fixed << std::setprecision(3) << std::setw(8) << Ratio(result)
+			<< std::setprecision(1) << std::setw(11) << Throughput(result.size, Median(result.encodeSeconds))
+			<< std::setw(11) << Throughput(result.size, Median(result.decodeSeconds))
+			<< std::setw(12) << result.encodePeakBytes << std::setw(12) << result.decodePeakBytes
+			<< (result.verified ? "" : "  MISMATCH") << std::defaultfloat << std::endl;
+	}
+
+	void WriteCsv(std::ostream& output, const std::vector<Result>& results)
+	{
+		output << "input,kind,method,size,encoded_size,ratio,encode_mbps,decode_mbps,encode_best_mbps,decode_best_mbps,"
+			"encode_peak_bytes,decode_peak_bytes,verified\n";
+
+		for (const Result& result : results)
+		{
+			double bestEncode = result.encodeSeconds.empty() ? 0.0 : *std::min_element(result.encodeSeconds.begin(), result.encodeSeconds.end());
+			double bestDecode = result.decodeSeconds.empty() ? 0.0 : *std::min_element(result.decodeSeconds.begin(), result.decodeSeconds.end());
+
+			output << EscapeCsv(result.input) << ',' << result.kind << ',' << result.method << ','
+				<< result.size << ',' << result.encodedSize << ',' << Ratio(result) << ','
+				<< Throughput(result.size, Median(result.encodeSeconds)) << ',' << Throughput(result.size, Median(result.decodeSeconds)) << ','
+				<< Throughput(result.size, bestEncode) << ',' << Throughput(result.size, bestDecode) << ','
+				<< result.encodePeakBytes << ',' << result.decodePeakBytes << ',' << (result.verified ? "true" : "false") << '\n';
+		}
+	}
+
+	void WriteJson(std::ostream& output, const Settings& settings, const std::vector<Result>& results)
+	{
+		auto writeSeconds = [&](const std::vector<double>& seconds)
+		{
+			output << '[';
+			for (std::size_t i = 0; i < seconds.size(); i++) output << (i ? ", " : "") << seconds[i];
+			output << ']';
+		};
+
+		output << "{\n"
+			<< "  \"settings\": { \"runs\": " << settings.runs << ", \"warmups\": " << settings.warmups
+			<< ", \"threads\": " << settings.threadCount << ", \"block_size\": " << settings.blockSize << " },\n"
+			<< "  \"results\": [\n";
+
+		for (std::size_t i = 0; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			output << "    { \"input\": \"" << EscapeJson(result.input) << "\", \"kind\": \"" << result.kind
+				<< "\", \"method\": \"" << result.method << "\", \"size\": " << result.size
+				<< ", \"encoded_size\": " << result.encodedSize << ", \"ratio\": " << Ratio(result)
+				<< ", \"encode_mbps\": " << Throughput(result.size, Median(result.encodeSeconds))
+				<< ", \"decode_mbps\": " << Throughput(result.size, Median(result.decodeSeconds))
+				<< ", \"encode_peak_bytes\": " << result.encodePeakBytes << ", \"decode_peak_bytes\": " << result.decodePeakBytes
+				<< ", \"verified\": " << (result.verified ? "true" : "false")
+				<< ", \"encode_seconds\": ";
+			writeSeconds(result.encodeSeconds);
+			output << ", \"decode_seconds\": ";
+			writeSeconds(result.decodeSeconds);
+			output << " }" << (i + 1 < results.size() ? "," : "") << '\n';
+		}
+
+		output << "  ]\n}\n";
+	}
+}
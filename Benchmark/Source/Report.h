@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Core/Core.h"
+#include <ostream>
+
+namespace Benchmark
+{
+	/**
+	* @brief Parameters of a benchmark run, written into the JSON report.
+	*/
+	struct Settings
+	{
+		unsigned runs;
+
+		unsigned warmups;
+
+		unsigned threadCount;
+
+		std::size_t blockSize;
+	};
+
+	/**
+	* @brief Measurements of one method on one input.
+	*/
+	struct Result
+	{
+		String input;
+
+		String kind;
+
+		String method;
+
+		std::size_t size;
+
+		std::size_t encodedSize;
+
+		/**< Duration of every measured run, warm-up runs excluded. */
+		std::vector<double> encodeSeconds;
+
+		std::vector<double> decodeSeconds;
+
+		/**< Largest heap growth during one encode, in bytes. */
+		std::size_t encodePeakBytes;
+
+		/**< Largest heap growth during one decode, in bytes. */
+		std::size_t decodePeakBytes;
+
+		/**< True if every decode reproduced the input. */
+		bool verified;
+	};
+
+	/**
+	* @brief Returns the median of the durations.
+	*/
+	double Median(std::vector<double> seconds);
+
+	/**
+	* @brief Returns the throughput in MB/s of size bytes processed in the given time.
+	*/
+	double Throughput(std::size_t size, double seconds);
+
+	/**
+	* @brief Prints the header of the human-readable table.
+	*/
+	void PrintTableHeader(std::ostream& output);
+
+	/**
+	* @brief Prints one row of the human-readable table, with median throughputs.
+	*/
+	void PrintTableRow(std::ostream& output, const Result& result);
+
+	/**
+	* @brief Writes the results as CSV, one row per input and method.
+	*/
+	void WriteCsv(std::ostream& output, const std::vector<Result>& results);
+
+	/**
+	* @brief Writes the settings and the results, with every run's duration, as JSON.
+	*/
+	void WriteJson(std::ostream& output, const Settings& settings, const std::vector<Result>& results);
+}
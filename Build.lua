@@ -14,4 +14,5 @@ group "Core"
 	include "Core/Build-Core.lua"
 group ""
 
-include "Pistone/Build-App.lua"
\ No newline at end of file
+include "Pistone/Build-App.lua"
+include "Benchmark/Build-Benchmark.lua"
\ No newline at end of file
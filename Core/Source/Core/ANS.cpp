@@ -0,0 +1,548 @@
+#include "ANS.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <istream>
+#include <ostream>
+
+namespace ANS
+{
+	static inline std::uint32_t SpreadStep(std::uint32_t tableSize)
+	{
+		return (tableSize >> 1) + (tableSize >> 3) + 3;
+	}
+
+	static void SpreadSymbols(const std::uint32_t* frequencies, int tableLog, std::uint8_t* tableSymbols)
+	{
+		const std::uint32_t tableSize = std::uint32_t(1) << tableLog;
+		const std::uint32_t step = SpreadStep(tableSize);
+		const std::uint32_t mask = tableSize - 1;
+
+		std::uint32_t position = 0;
+		for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+		{
+			for (std::uint32_t i = 0; i < frequencies[symbol]; i++)
+			{
+				tableSymbols[position] = static_cast<std::uint8_t>(symbol);
+				position = (position + step) & mask;
+			}
+		}
+	}
+
+	void NormalizeCounts(const std::uint64_t* counts, std::uint64_t total, int tableLog, std::uint32_t* frequencies)
+	{
+		const std::uint32_t tableSize = std::uint32_t(1) << tableLog;
+		const double scale = static_cast<double>(tableSize) / static_cast<double>(total);
+
+		std::uint64_t sum = 0;
+		for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+		{
+			frequencies[symbol] = 0;
+			if (counts[symbol] == 0) continue;
+
+			frequencies[symbol] = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(counts[symbol] * scale + 0.5));
+			sum += frequencies[symbol];
+		}
+
+		while (sum > tableSize)
+		{
+			std::size_t best = 0;
+			double bestLoss = INFINITY;
+			for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+			{
+				if (frequencies[symbol] <= 1) continue;
+
+				double loss = counts[symbol] * std::log2(frequencies[symbol] / (frequencies[symbol] - 1.0));
+				if (loss < bestLoss)
+				{
+					bestLoss = loss;
+					best = symbol;
+				}
+			}
+			frequencies[best]--;
+			sum--;
+		}
+
+		while (sum < tableSize)
+		{
+			std::size_t best = 0;
+			double bestGain = -1;
+			for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+			{
+				if (counts[symbol] == 0) continue;
+
+				double gain = counts[symbol] * std::log2((frequencies[symbol] + 1.0) / frequencies[symbol]);
+				if (gain > bestGain)
+				{
+					bestGain = gain;
+					best = symbol;
+				}
+			}
+			frequencies[best]++;
+			sum++;
+		}
+	}
+
+	void EncodeBlock(const char* data, std::size_t dataSize, std::vector<char>& encodedBlock, int maxTableLog)
+	{
+		ANSEncoder encoder(dataSize, 1, maxTableLog);
+
+		std::size_t offset = encodedBlock.size();
+		encodedBlock.resize(offset + BlockBound(dataSize) + 8);
+		encodedBlock.resize(offset + encoder.encodeBlock(data, dataSize, encodedBlock.data() + offset, encodedBlock.size() - offset));
+	}
+
+	void DecodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize)
+	{
+		ANSDecoder decoder(1);
+		decoder.decodeBlock(block, blockSize, output, outputSize);
+	}
+
+	ANSEncoder::ANSEncoder(std::size_t blockSize, unsigned threadCount, int maxTableLog)
+		: blockSize(std::max<std::size_t>(blockSize, 1)), threadCount(std::max(threadCount, 1u)),
+		maxTableLog(std::clamp(maxTableLog, kMinTableLog, kMaxTableLog)) {}
+
+	std::size_t ANSEncoder::encode(std::span<const std::byte> data, std::span<std::byte> encodedData)
+	{
+		const char* input = reinterpret_cast<const char*>(data.data());
+		char* output = reinterpret_cast<char*>(encodedData.data());
+
+		if (data.size() <= blockSize)
+		{
+			if (encodedData.size() < 2) throw Core::CompressionException("Output buffer too small");
+
+			output[0] = static_cast<char>(Huffman::kFormatMarker | kFormatVersion);
+			output[1] = 0;
+
+			Core::BlockTimer timer(data.size());
+			std::size_t size = 2 + encodeBlock(input, data.size(), output + 2, encodedData.size() - 2);
+			timer.stop(size);
+			return size;
+		}
+
+		auto encodeBlock = [this](const char* block, std::size_t size, std::vector<char>& encodedBlock)
+		{
+			EncodeBlock(block, size, encodedBlock, maxTableLog);
+		};
+
+		std::vector<char> container;
+		Core::EncodeBlocks(Huffman::kFormatMarker | kContainerVersion, 0, input, data.size(), blockSize, threadCount, encodeBlock, container);
+		if (container.size() > encodedData.size()) throw Core::CompressionException("Output buffer too small");
+
+		std::copy(container.begin(), container.end(), output);
+		return container.size();
+	}
+
+	std::size_t ANSEncoder::encodeBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity)
+	{
+		const std::uint8_t* input = reinterpret_cast<const std::uint8_t*>(data);
+
+		char header[Core::kMaxVarintSize + 1];
+		std::size_t headerSize = Core::WriteVarint(header, dataSize);
+		std::size_t storedSize = headerSize + 1 + dataSize;
+
+		std::uint64_t payloadBits = 0;
+		int tableLog = 0;
+		std::uint32_t stateA = 0;
+		std::uint32_t stateB = 0;
+		std::uint64_t symbolBitCount = 0;
+		if (dataSize > 0)
+		{
+			{
+				Core::ScopedTimer timer(Core::Phase::Histogram);
+				Core::CountBytes(input, dataSize, counts, threadCount);
+			}
+			Core::ScopedTimer tablesTimer(Core::Phase::CodeLengths);
+
+			int usedCount = static_cast<int>(std::count_if(counts, counts + Huffman::kAlphabetSize, [](std::uint64_t count) { return count > 0; }));
+
+			// More states than symbols only pay for a longer header.
+			tableLog = std::min(maxTableLog, static_cast<int>(std::bit_width(dataSize - 1)));
+			tableLog = std::max({ tableLog, kMinTableLog, static_cast<int>(std::bit_width(static_cast<unsigned>(usedCount - 1))) });
+
+			NormalizeCounts(counts, dataSize, tableLog, frequencies);
+
+			payloadBits = 2 * tableLog;
+			for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+			{
+				payloadBits += 2 * (std::bit_width(frequencies[symbol] + 1) - 1) + 1;
+			}
+
+			const std::uint32_t tableSize = std::uint32_t(1) << tableLog;
+			std::uint8_t tableSymbols[1 << kMaxTableLog];
+			SpreadSymbols(frequencies, tableLog, tableSymbols);
+
+			std::uint32_t cumulative[Huffman::kAlphabetSize];
+			std::uint32_t total = 0;
+			for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+			{
+				std::uint32_t frequency = frequencies[symbol];
+				cumulative[symbol] = total;
+
+				if (frequency == 1)
+				{
+					transforms[symbol] = { static_cast<std::int32_t>(total) - 1, (static_cast<std::uint32_t>(tableLog) << 16) - tableSize };
+				}
+				else if (frequency > 1)
+				{
+					std::uint32_t maxBitsOut = tableLog - (std::bit_width(frequency - 1) - 1);
+					std::uint32_t minStatePlus = frequency << maxBitsOut;
+					transforms[symbol] = { static_cast<std::int32_t>(total - frequency), (maxBitsOut << 16) - minStatePlus };
+				}
+				total += frequency;
+			}
+
+			for (std::uint32_t position = 0; position < tableSize; position++)
+			{
+				stateTable[cumulative[tableSymbols[position]]++] = static_cast<std::uint16_t>(tableSize + position);
+			}
+
+			tablesTimer.stop();
+
+			Core::ScopedTimer timer(Core::Phase::Packing);
+			symbolBits.resize(dataSize);
+			stateA = tableSize;
+			stateB = tableSize;
+
+			auto encodeSymbol = [&](std::uint32_t& state, std::size_t index)
+			{
+				const SymbolTransform& transform = transforms[input[index]];
+				std::uint32_t nbBits = (state + transform.deltaNbBits) >> 16;
+				symbolBits[index] = static_cast<std::uint16_t>(((state & ((std::uint32_t(1) << nbBits) - 1)) << 4) | nbBits);
+				symbolBitCount += nbBits;
+				state = stateTable[(state >> nbBits) + transform.deltaFindState];
+			};
+
+			std::size_t i = dataSize;
+			if (i & 1) encodeSymbol(stateA, --i);
+			while (i > 0)
+			{
+				i -= 2;
+				encodeSymbol(stateB, i + 1);
+				encodeSymbol(stateA, i);
+			}
+
+			payloadBits += symbolBitCount;
+			stateA -= tableSize;
+			stateB -= tableSize;
+		}
+
+		std::size_t encodedSize = headerSize + 1 + (payloadBits + 7) / 8;
+		if (dataSize == 0 || encodedSize >= storedSize)
+		{
+			if (storedSize > capacity) throw Core::CompressionException("Output buffer too small");
+
+			std::copy_n(header, headerSize, encodedBlock);
+			encodedBlock[headerSize] = static_cast<char>(kStoredBlock);
+			std::copy_n(data, dataSize, encodedBlock + headerSize + 1);
+
+			Core::AddCounter(Core::Counter::HeaderBytes, headerSize + 1);
+			Core::AddCounter(Core::Counter::StoredBlocks, 1);
+			return storedSize;
+		}
+		if (encodedSize > capacity) throw Core::CompressionException("Output buffer too small");
+
+		Core::ScopedTimer timer(Core::Phase::Packing);
+		Core::AddCounter(Core::Counter::Symbols, dataSize);
+		Core::AddCounter(Core::Counter::CodedBits, symbolBitCount);
+		Core::AddCounter(Core::Counter::HeaderBytes, encodedSize - (symbolBitCount + 7) / 8);
+
+		char* payload = encodedBlock + headerSize + 1;
+		if (capacity - encodedSize < 8)
+		{
+			scratch.resize(encodedSize - headerSize - 1 + 8);
+			payload = scratch.data();
+		}
+
+		Core::BitWriter writer(reinterpret_cast<std::uint8_t*>(payload));
+		for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+		{
+			std::uint32_t value = frequencies[symbol] + 1;
+			int zeros = std::bit_width(value) - 1;
+			writer.write(std::uint64_t(1) << zeros, zeros + 1);
+			writer.write(value & ((std::uint32_t(1) << zeros) - 1), zeros);
+			writer.flush();
+		}
+
+		writer.write(stateA, tableLog);
+		writer.write(stateB, tableLog);
+		writer.flush();
+
+		std::size_t i = 0;
+		for (; i + 4 <= dataSize; i += 4)
+		{
+			for (std::size_t k = 0; k < 4; k++)
+			{
+				std::uint16_t bits = symbolBits[i + k];
+				writer.write(bits >> 4, bits & 0xF);
+			}
+			writer.flush();
+		}
+		for (; i < dataSize; i++)
+		{
+			std::uint16_t bits = symbolBits[i];
+			writer.write(bits >> 4, bits & 0xF);
+			writer.flush();
+		}
+
+		std::size_t payloadSize = writer.finish();
+		if (payload != encodedBlock + headerSize + 1) std::copy_n(payload, payloadSize, encodedBlock + headerSize + 1);
+		std::copy_n(header, headerSize, encodedBlock);
+		encodedBlock[headerSize] = static_cast<char>(tableLog);
+
+		return headerSize + 1 + payloadSize;
+	}
+
+	ANSDecoder::ANSDecoder(unsigned threadCount) : threadCount(std::max(threadCount, 1u)) {}
+
+	std::size_t ANSDecoder::decodedSize(std::span<const std::byte> encodedData)
+	{
+		std::span<const char> input(reinterpret_cast<const char*>(encodedData.data()), encodedData.size());
+		if (input.empty()) throw Core::CompressionException("Invalid data format");
+
+		switch (static_cast<std::uint8_t>(input[0]))
+		{
+			case Huffman::kFormatMarker | kFormatVersion:
+			{
+				if (input.size() < 3) throw Core::CompressionException("Invalid data format");
+				if (input[1] != 0) throw Core::CompressionException("Unsupported format flags");
+
+				std::size_t offset = 2;
+				std::size_t symbolCount = Core::ReadVarint(input.data(), input.size(), offset);
+
+				// A single-symbol block codes its symbols in no bits, only the block size limits it.
+				if (symbolCount > Core::kMaxBlockSize) throw Core::CompressionException("Invalid data format");
+
+				return symbolCount;
+			}
+
+			case Huffman::kFormatMarker | kContainerVersion:
+			{
+				Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+				if (index.flags != 0) throw Core::CompressionException("Unsupported format flags");
+
+				return index.originalSize;
+			}
+
+			default:
+				throw Core::CompressionException("Unsupported format version");
+		}
+	}
+
+	std::size_t ANSDecoder::decode(std::span<const std::byte> encodedData, std::span<std::byte> data)
+	{
+		std::size_t size = decodedSize(encodedData);
+		if (size > data.size()) throw Core::CompressionException("Output buffer too small");
+
+		std::span<const char> input(reinterpret_cast<const char*>(encodedData.data()), encodedData.size());
+		char* output = reinterpret_cast<char*>(data.data());
+
+		if (static_cast<std::uint8_t>(input[0]) == (Huffman::kFormatMarker | kFormatVersion))
+		{
+			Core::BlockTimer timer(input.size());
+			decodeBlock(input.data() + 2, input.size() - 2, output, size);
+			timer.stop(size);
+		}
+		else
+		{
+			Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+			Core::DecodeBlocks(input.data(), index, 0, index.originalSize, output, threadCount, DecodeBlock);
+		}
+
+		return size;
+	}
+
+	void ANSDecoder::decodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize)
+	{
+		std::size_t offset = 0;
+		std::uint64_t symbolCount = Core::ReadVarint(block, blockSize, offset);
+		if (symbolCount != outputSize) throw Core::CompressionException("Block size does not match the block index");
+		if (offset >= blockSize) throw Core::CompressionException("Invalid data format");
+
+		int tableLog = static_cast<std::uint8_t>(block[offset++]);
+		if (tableLog == kStoredBlock)
+		{
+			if (blockSize - offset != outputSize) throw Core::CompressionException("Invalid data format");
+			std::copy_n(block + offset, outputSize, output);
+			return;
+		}
+		if (tableLog < kMinTableLog || tableLog > kMaxTableLog) throw Core::CompressionException("Invalid data format");
+
+		Core::ScopedTimer tablesTimer(Core::Phase::CodeLengths);
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(block);
+		Core::BitReader reader(bytes + offset, blockSize - offset);
+
+		const std::uint32_t tableSize = std::uint32_t(1) << tableLog;
+		std::uint32_t frequencies[Huffman::kAlphabetSize];
+		std::uint32_t sum = 0;
+		for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++)
+		{
+			reader.refill();
+			int zeros = std::countr_zero(static_cast<std::uint32_t>(reader.peek(32)));
+			if (zeros > tableLog) throw Core::CompressionException("Invalid data format");
+			reader.consume(zeros + 1);
+
+			frequencies[symbol] = ((std::uint32_t(1) << zeros) | static_cast<std::uint32_t>(reader.peek(zeros))) - 1;
+			reader.consume(zeros);
+
+			sum += frequencies[symbol];
+			if (sum > tableSize) throw Core::CompressionException("Invalid data format");
+		}
+		if (sum != tableSize) throw Core::CompressionException("Invalid data format");
+
+		std::uint8_t tableSymbols[1 << kMaxTableLog];
+		SpreadSymbols(frequencies, tableLog, tableSymbols);
+		for (std::uint32_t state = 0; state < tableSize; state++)
+		{
+			std::uint8_t symbol = tableSymbols[state];
+			std::uint32_t next = frequencies[symbol]++;
+			int nbBits = tableLog - (std::bit_width(next) - 1);
+			table[state] = { static_cast<std::uint16_t>((next << nbBits) - tableSize), symbol, static_cast<std::uint8_t>(nbBits) };
+		}
+
+		tablesTimer.stop();
+
+		Core::ScopedTimer timer(Core::Phase::Unpacking);
+		reader.refill();
+		std::uint32_t stateA = static_cast<std::uint32_t>(reader.peek(tableLog));
+		reader.consume(tableLog);
+		std::uint32_t stateB = static_cast<std::uint32_t>(reader.peek(tableLog));
+		reader.consume(tableLog);
+
+		auto decodeSymbol = [&](std::uint32_t& state, std::size_t index)
+		{
+			const DecodeEntry& entry = table[state];
+			output[index] = static_cast<char>(entry.symbol);
+			state = entry.newState + static_cast<std::uint32_t>(reader.peek(entry.nbBits));
+			reader.consume(entry.nbBits);
+		};
+
+		const std::size_t symbolsPerRefill = (56 / tableLog) & ~std::size_t(1);
+		std::size_t i = 0;
+		while (i + symbolsPerRefill <= outputSize)
+		{
+			reader.refill();
+			for (std::size_t k = 0; k < symbolsPerRefill; k += 2)
+			{
+				decodeSymbol(stateA, i++);
+				decodeSymbol(stateB, i++);
+			}
+		}
+		while (i < outputSize)
+		{
+			reader.refill();
+			decodeSymbol(i & 1 ? stateB : stateA, i);
+			i++;
+		}
+
+		if (reader.overflowed()) throw Core::CompressionException("Invalid data format");
+	}
+
+	ANSCompression::ANSCompression(std::size_t blockSize, unsigned threadCount, std::size_t memoryBudget, int maxTableLog)
+		: blockSize(std::clamp<std::size_t>(blockSize, 1, Core::kMaxBlockSize)), threadCount(std::max(threadCount, 1u)), memoryBudget(memoryBudget),
+		maxTableLog(std::clamp(maxTableLog, kMinTableLog, kMaxTableLog)) {}
+
+	std::size_t ANSCompression::compressBound(std::size_t dataSize) const
+	{
+		if (dataSize <= blockSize) return 2 + BlockBound(dataSize) + 8;
+
+		return Core::ContainerBound(dataSize, blockSize, BlockBound(0));
+	}
+
+	std::unique_ptr<Core::EncoderContext> ANSCompression::createEncoder() const
+	{
+		return std::make_unique<ANSEncoder>(blockSize, threadCount, maxTableLog);
+	}
+
+	std::unique_ptr<Core::DecoderContext> ANSCompression::createDecoder() const
+	{
+		return std::make_unique<ANSDecoder>(threadCount);
+	}
+
+	void ANSCompression::decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const
+	{
+		if (dataToDecode.empty() || static_cast<std::uint8_t>(dataToDecode[0]) != (Huffman::kFormatMarker | kContainerVersion))
+		{
+			Core::CompressionMethod::decodeRange(dataToDecode, offset, length, data);
+			return;
+		}
+
+		Core::BlockIndex index = Core::ReadBlockIndex(dataToDecode.data(), dataToDecode.size());
+		if (index.flags != 0) throw Core::CompressionException("Unsupported format flags");
+
+		offset = std::min(offset, index.originalSize);
+		length = std::min(length, index.originalSize - offset);
+
+		std::size_t outputOffset = data.size();
+		data.resize(outputOffset + length);
+		Core::DecodeBlocks(dataToDecode.data(), index, offset, length, data.data() + outputOffset, threadCount, DecodeBlock);
+	}
+
+	void ANSCompression::encodeStream(std::istream& input, std::ostream& output) const
+	{
+		Core::EncodeBlockStream(Huffman::kFormatMarker | kContainerVersion, Huffman::kFormatMarker | kFormatVersion, 0, input, output,
+			blockSize, threadCount, memoryBudget, blockEncoder());
+	}
+
+	void ANSCompression::decodeStream(std::istream& input, std::ostream& output) const
+	{
+		int first = input.peek();
+		if (first != (Huffman::kFormatMarker | kContainerVersion))
+		{
+			std::vector<char> dataToDecode;
+			char buffer[1 << 16];
+			while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0)
+			{
+				dataToDecode.insert(dataToDecode.end(), buffer, buffer + input.gcount());
+			}
+
+			std::vector<char> data;
+			decode(dataToDecode, data);
+			output.write(data.data(), data.size());
+		}
+		else
+		{
+			input.get();
+			if (input.get() != 0) throw Core::CompressionException("Unsupported format flags");
+
+			Core::DecodeBlockStream(input, output, threadCount, memoryBudget, BlockBound(0), DecodeBlock);
+		}
+
+		if (!output) throw Core::CompressionException("Error writing output");
+	}
+
+	void ANSCompression::encodeStream(std::span<const char> input, std::ostream& output) const
+	{
+		Core::EncodeBlockStream(Huffman::kFormatMarker | kContainerVersion, Huffman::kFormatMarker | kFormatVersion, 0, input, output,
+			blockSize, threadCount, memoryBudget, blockEncoder());
+	}
+
+	void ANSCompression::decodeStream(std::span<const char> input, std::ostream& output) const
+	{
+		if (input.empty() || static_cast<std::uint8_t>(input[0]) != (Huffman::kFormatMarker | kContainerVersion))
+		{
+			std::vector<char> data;
+			decode(input, data);
+			output.write(data.data(), data.size());
+		}
+		else
+		{
+			Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+			if (index.flags != 0) throw Core::CompressionException("Unsupported format flags");
+
+			Core::DecodeBlockStream(input.data(), index, output, threadCount, memoryBudget, DecodeBlock);
+		}
+
+		if (!output) throw Core::CompressionException("Error writing output");
+	}
+
+	Core::BlockEncoder ANSCompression::blockEncoder() const
+	{
+		return [maxTableLog = maxTableLog](const char* data, std::size_t size, std::vector<char>& encodedBlock)
+		{
+			EncodeBlock(data, size, encodedBlock, maxTableLog);
+		};
+	}
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "Core.h"
+#include "BitStream.h"
+#include "BlockContainer.h"
+#include "Histogram.h"
+#include "Huffman.h"
+
+namespace ANS
+{
+	/**
+	* @brief Version of the single-block tANS stream, the first byte is Huffman::kFormatMarker | kFormatVersion.
+	*
+	* The stream format:
+	* - 8 bits: Huffman::kFormatMarker | kFormatVersion
+	* - 8 bits: flags, reserved (0)
+	* - A block written by ANSEncoder::encodeBlock
+	*/
+	constexpr std::uint8_t kFormatVersion = 6;
+
+	/**
+	* @brief Version of the tANS block container, see Core::EncodeBlocks.
+	*/
+	constexpr std::uint8_t kContainerVersion = 7;
+
+	/**
+	* @brief Smallest state table, as a power of two.
+	*/
+	constexpr int kMinTableLog = 5;
+
+	/**
+	* @brief Largest state table, as a power of two. Bits and bit counts of one symbol share 16 bits.
+	*/
+	constexpr int kMaxTableLog = 12;
+
+	/**
+	* @brief Default largest state table, 2048 states.
+	*/
+	constexpr int kDefaultTableLog = 11;
+
+	/**
+	* @brief Table log byte of a block holding the input unchanged.
+	*/
+	constexpr std::uint8_t kStoredBlock = 0;
+
+	/**
+	* @brief Returns the largest size of a block encoding dataSize bytes.
+	*
+	* Blocks that would not shrink are stored, so a block never exceeds its input by more than its header.
+	*/
+	constexpr std::size_t BlockBound(std::size_t dataSize) { return Core::kMaxVarintSize + 1 + dataSize; }
+
+	/**
+	* @brief Scales symbol counts to frequencies summing to 1 << tableLog.
+	*
+	* Every symbol that occurs keeps a frequency of at least 1, the rounding error is then
+	* spread over the symbols where it costs the fewest coded bits.
+	*
+	* @param counts Array of 256 symbol counts.
+	* @param total Sum of the counts, must not be 0.
+	* @param tableLog Table size as a power of two, at least the number of symbols that occur.
+	* @param frequencies Array of 256 frequencies receiving the result.
+	*/
+	void NormalizeCounts(const std::uint64_t* counts, std::uint64_t total, int tableLog, std::uint32_t* frequencies);
+
+	/**
+	* @brief Encodes one block through a temporary ANSEncoder, see ANSEncoder::encodeBlock.
+	*
+	* @throw Core::CompressionException if there is an error during encoding.
+	*/
+	void EncodeBlock(const char* data, std::size_t dataSize, std::vector<char>& encodedBlock, int maxTableLog = kDefaultTableLog);
+
+	/**
+	* @brief Decodes one block through a temporary ANSDecoder, see ANSDecoder::decodeBlock.
+	*
+	* @throw Core::CompressionException if the block is malformed.
+	*/
+	void DecodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize);
+
+	/**
+	* @brief Reusable tANS encoder keeping its histogram, state tables and symbol buffer between calls.
+	*/
+	class ANSEncoder : public Core::EncoderContext
+	{
+	public:
+		/**
+		* @brief Constructs the encoder.
+		*
+		* @param blockSize Amount of input per independently encoded block.
+		* @param threadCount Number of threads encoding the blocks of large inputs, or counting the symbols of a large single block.
+		* @param maxTableLog Largest state table as a power of two, clamped to [kMinTableLog, kMaxTableLog].
+		*/
+		ANSEncoder(std::size_t blockSize, unsigned threadCount, int maxTableLog = kDefaultTableLog);
+
+		/**
+		* @brief Encodes data into a caller-provided buffer.
+		*
+		* Inputs fitting in one block are written as a single-block stream, larger inputs are
+		* split into blocks encoded on threadCount threads and framed into a block container.
+		*
+		* @throw Core::CompressionException if the buffer is too small or there is an error during encoding.
+		*/
+		std::size_t encode(std::span<const std::byte> data, std::span<std::byte> encodedData) override;
+
+		/**
+		* @brief Encodes one block.
+		*
+		* Symbols are coded by two interleaved tANS states, even symbols by the first and odd
+		* symbols by the second. The encoder walks the block backwards, so the bits of every
+		* symbol are buffered and written in the decoder's order afterwards.
+		*
+		* The block format:
+		* - varint: size of the original data
+		* - 8 bits: table log, or kStoredBlock followed by the original data
+		* - LSB-first bitstream:
+		*   - per byte value: frequency + 1 as an Elias gamma code, the zeros of the unary part first
+		*   - table log bits per state: the two initial decoder states
+		*   - per symbol: the bits restoring the state of its lane
+		*
+		* @param data Pointer to the data to be encoded.
+		* @param dataSize The size of the data.
+		* @param encodedBlock Buffer receiving the encoded block, BlockBound(dataSize) bytes always suffice.
+		* @param capacity The size of the buffer.
+		* @return The size of the encoded block.
+		*
+		* @throw Core::CompressionException if the buffer is too small.
+		*/
+		std::size_t encodeBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity);
+
+	private:
+		/**
+		* @brief Per-symbol constants turning an encoder state into the bit count and the next state.
+		*/
+		struct SymbolTransform
+		{
+			std::int32_t deltaFindState;
+
+			std::uint32_t deltaNbBits;
+		};
+
+		std::size_t blockSize;
+
+		unsigned threadCount;
+
+		int maxTableLog;
+
+		std::uint64_t counts[Huffman::kAlphabetSize];
+
+		std::uint32_t frequencies[Huffman::kAlphabetSize];
+
+		SymbolTransform transforms[Huffman::kAlphabetSize];
+
+		std::uint16_t stateTable[1 << kMaxTableLog];
+
+		/**< Bits of every symbol in the block, (bits << 4) | bit count. */
+		std::vector<std::uint16_t> symbolBits;
+
+		std::vector<char> scratch;
+	};
+
+	/**
+	* @brief Reusable tANS decoder keeping its state table between calls.
+	*/
+	class ANSDecoder : public Core::DecoderContext
+	{
+	public:
+		/**
+		* @brief Constructs the decoder.
+		*
+		* @param threadCount Number of threads decoding blocks of block containers concurrently.
+		*/
+		explicit ANSDecoder(unsigned threadCount);
+
+		/**
+		* @brief Returns the decoded size stored in the stream header.
+		*
+		* @throw Core::CompressionException if the data format is invalid.
+		*/
+		std::size_t decodedSize(std::span<const std::byte> encodedData) override;
+
+		/**
+		* @brief Decodes data into a caller-provided buffer.
+		*
+		* @throw Core::CompressionException if the buffer is too small or there is an error during decoding.
+		*/
+		std::size_t decode(std::span<const std::byte> encodedData, std::span<std::byte> data) override;
+
+		/**
+		* @brief Decodes one block written by ANSEncoder::encodeBlock.
+		*
+		* @param block Pointer to the encoded block.
+		* @param blockSize The size of the encoded block.
+		* @param output Pointer to the buffer receiving the decoded data.
+		* @param outputSize The number of symbols the block must decode to.
+		*
+		* @throw Core::CompressionException if the block is malformed.
+		*/
+		void decodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize);
+
+	private:
+		/**
+		* @brief One decoder state: its symbol and how to reach the next state.
+		*/
+		struct DecodeEntry
+		{
+			std::uint16_t newState;
+
+			std::uint8_t symbol;
+
+			std::uint8_t nbBits;
+		};
+
+		unsigned threadCount;
+
+		DecodeEntry table[1 << kMaxTableLog];
+	};
+
+	/**
+	* @brief A class containing the tANS compression method, coding bytes with fractional bit costs.
+	*/
+	class ANSCompression : public Core::CompressionMethod, public Core::StreamCompressionMethod
+	{
+	public:
+		/**
+		* @brief Constructs the method.
+		*
+		* @param blockSize Amount of input per independently encoded block.
+		* @param threadCount Number of threads encoding and decoding blocks concurrently.
+		* @param memoryBudget Bytes the streaming encoder and decoder may use for blocks in flight.
+		* @param maxTableLog Largest state table as a power of two, larger tables follow the symbol statistics more closely.
+		*/
+		explicit ANSCompression(std::size_t blockSize = Core::kDefaultBlockSize, unsigned threadCount = 1, std::size_t memoryBudget = Core::kDefaultMemoryBudget,
+			int maxTableLog = kDefaultTableLog);
+
+		/**
+		* @brief Returns the largest encoded size of dataSize bytes, including the bit writer's slack.
+		*/
+		std::size_t compressBound(std::size_t dataSize) const override;
+
+		/**
+		* @brief Creates an ANSEncoder with this method's parameters.
+		*/
+		std::unique_ptr<Core::EncoderContext> createEncoder() const override;
+
+		/**
+		* @brief Creates an ANSDecoder with this method's thread count.
+		*/
+		std::unique_ptr<Core::DecoderContext> createDecoder() const override;
+
+		/**
+		* @brief Decodes only the bytes [offset, offset + length) of the original data.
+		*
+		* For block containers only the blocks covering the range are decoded, on threadCount threads.
+		*
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const override;
+
+		/**
+		* @brief Encodes a stream in blocks, keeping at most memoryBudget bytes of blocks in flight.
+		*
+		* @throw Core::CompressionException if there is an error during encoding.
+		*/
+		void encodeStream(std::istream& input, std::ostream& output) const override;
+
+		/**
+		* @brief Decodes a stream written by encode or encodeStream.
+		*
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeStream(std::istream& input, std::ostream& output) const override;
+
+		/**
+		* @brief Encodes an input already in memory, block by block straight from the input view.
+		*
+		* @throw Core::CompressionException if there is an error during encoding.
+		*/
+		void encodeStream(std::span<const char> input, std::ostream& output) const override;
+
+		/**
+		* @brief Decodes an input already in memory, block containers in ranges bounded by memoryBudget.
+		*
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeStream(std::span<const char> input, std::ostream& output) const override;
+
+	private:
+		/**
+		* @brief Returns the block encoder used by the container and stream paths.
+		*/
+		Core::BlockEncoder blockEncoder() const;
+
+		std::size_t blockSize;
+
+		unsigned threadCount;
+
+		std::size_t memoryBudget;
+
+		int maxTableLog;
+	};
+}
@@ -0,0 +1,527 @@
+#include "Archive.h"
+#include "Checksum.h"
+#include "MappedFile.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+
+namespace Core
+{
+	static constexpr std::size_t kTrailerSize = 12;
+
+	static void WriteLE(std::vector<char>& data, std::uint64_t value, int size)
+	{
+		for (int offset = 0; offset < size; offset++) data.push_back(static_cast<char>((value >> (offset * 8)) & 0xFF));
+	}
+
+	static std::uint64_t ReadLE(const char* data, int size)
+	{
+		std::uint64_t value = 0;
+		for (int offset = 0; offset < size; offset++) value |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(data[offset])) << (offset * 8);
+		return value;
+	}
+
+	static String NormalizedPath(const String& path)
+	{
+		String normalized = path;
+		std::replace(normalized.begin(), normalized.end(), '\\', '/');
+		while (!normalized.empty() && normalized.back() == '/') normalized.pop_back();
+		return normalized;
+	}
+
+	static bool IsSafePath(const String& path)
+	{
+		fs::path entryPath(path);
+		if (path.empty() || entryPath.has_root_name() || entryPath.has_root_directory()) return false;
+
+		for (const fs::path& component : entryPath)
+		{
+			if (component == "..") return false;
+		}
+		return true;
+	}
+
+	/**
+	* @brief A compressed file other files are compared with, keyed by ContentKey.
+	*/
+	struct ContentOwner
+	{
+		std::size_t index;
+
+		String filePath;
+	};
+
+	static std::uint64_t ContentKey(std::uint64_t size, std::uint32_t checksum)
+	{
+		return (size << 32 | size >> 32) ^ checksum;
+	}
+
+	static bool SameContents(const String& filePath, std::span<const char> data)
+	{
+		MappedFile file(filePath);
+		return file.size() == data.size() && std::memcmp(file.data(), data.data(), data.size()) == 0;
+	}
+
+	bool IsArchive(std::span<const char> data)
+	{
+		return data.size() >= 2 + kTrailerSize && static_cast<std::uint8_t>(data[0]) == kArchiveMarker;
+	}
+
+	static std::int64_t ModifiedTime(const fs::directory_entry& entry, std::error_code& error)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(entry.last_write_time(error).time_since_epoch()).count();
+	}
+
+	static void CreateDirectories(const fs::path& path)
+	{
+		std::error_code error;
+		fs::create_directories(path, error);
+		if (error) throw CompressionException("Error creating folder: " + path.string());
+	}
+
+	void EncodeFolder(const String& folderPath, std::ostream& output, unsigned threadCount, std::size_t memoryBudget, const EntryEncoder& encodeEntry,
+		std::span<const char> previousArchive, std::span<const char> dictionary)
+	{
+		if (!fs::is_directory(folderPath)) throw CompressionException("Error loading: " + folderPath);
+
+		std::vector<ArchiveEntry> previousEntries;
+		std::unordered_map<String, const ArchiveEntry*> previousFiles;
+		if (!previousArchive.empty())
+		{
+			previousEntries = ReadArchiveDirectory(previousArchive.data(), previousArchive.size());
+			std::span<const char> previousDictionary = ReadArchiveDictionary(previousArchive.data(), previousArchive.size());
+			if (!std::ranges::equal(previousDictionary, dictionary)) previousEntries.clear();
+			for (const ArchiveEntry& entry : previousEntries)
+			{
+				if (entry.type != EntryType::Directory) previousFiles[entry.path] = &entry;
+			}
+		}
+
+		output.put(static_cast<char>(kArchiveMarker));
+		output.put(static_cast<char>(kArchiveVersion));
+		std::uint64_t outputOffset = 2;
+
+		std::vector<ArchiveEntry> entries;
+		std::unordered_map<std::uint64_t, std::vector<ContentOwner>> filesByContent;
+		std::unordered_map<std::uint64_t, std::size_t> entryOfPreviousOffset;
+		std::mutex mutex;
+		std::condition_variable budgetReleased;
+		std::size_t bytesInFlight = 0;
+
+		ThreadPool pool(threadCount);
+		std::error_code error;
+		fs::recursive_directory_iterator iterator(folderPath, error);
+		for (; !error && iterator != fs::recursive_directory_iterator(); iterator.increment(error))
+		{
+			const fs::directory_entry& entry = *iterator;
+			String path = entry.path().lexically_relative(folderPath).generic_string();
+			fs::file_status status = entry.status(error);
+
+			// A dangling link is skipped like any other entry that is not a file or folder.
+			if (status.type() == fs::file_type::not_found) error.clear();
+			bool isDirectory = fs::is_directory(status);
+			bool isFile = fs::is_regular_file(status);
+			std::size_t fileSize = isFile ? entry.file_size(error) : 0;
+			std::int64_t modifiedTime = isFile && !error ? ModifiedTime(entry, error) : 0;
+			if (error) throw CompressionException("Error loading: " + entry.path().string());
+
+			if (isDirectory)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				entries.push_back({ path, EntryType::Directory, 0, 0, 0, 0, 0, 0 });
+				continue;
+			}
+			if (!isFile) continue;
+
+			auto previousFile = previousFiles.find(path);
+			const ArchiveEntry* previous = previousFile != previousFiles.end() ? previousFile->second : nullptr;
+
+			// An unchanged file is copied from the previous archive without being read.
+			bool unchanged = previous && previous->size == fileSize && previous->modifiedTime == modifiedTime;
+			std::size_t charge = unchanged ? 0 : std::min<std::size_t>(fileSize, memoryBudget);
+			std::size_t index = 0;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				budgetReleased.wait(lock, [&] { return bytesInFlight == 0 || bytesInFlight + charge <= memoryBudget; });
+				bytesInFlight += charge;
+				index = entries.size();
+				entries.push_back({ path, EntryType::File, 0, 0, 0, 0, 0, modifiedTime });
+			}
+
+			pool.submit([&, index, charge, previous, unchanged, filePath = entry.path().string()]
+			{
+				auto release = [&]
+				{
+					bytesInFlight -= charge;
+					budgetReleased.notify_all();
+				};
+
+				try
+				{
+					std::vector<char> encoded;
+					std::span<const char> stored;
+					std::size_t size = 0;
+					std::uint32_t checksum = 0;
+					bool reused = unchanged;
+					if (unchanged)
+					{
+						size = previous->size;
+						checksum = previous->checksum;
+					}
+					else
+					{
+						ScopedTimer readTimer(Phase::ReadInput);
+						MappedFile file(filePath);
+						readTimer.stop();
+
+						size = file.size();
+						checksum = Crc32(file.view());
+
+						// A file with a new time but the same contents is reused as well.
+						reused = previous && previous->size == size && previous->checksum == checksum;
+
+						// Files registered earlier are compared, this one is registered for the later ones.
+						std::vector<ContentOwner> candidates;
+						if (size > 0 && !reused)
+						{
+							std::lock_guard<std::mutex> lock(mutex);
+							std::vector<ContentOwner>& owners = filesByContent[ContentKey(size, checksum)];
+							candidates = owners;
+							owners.push_back({ index, filePath });
+						}
+
+						for (const ContentOwner& candidate : candidates)
+						{
+							if (!SameContents(candidate.filePath, file.view())) continue;
+
+							std::lock_guard<std::mutex> lock(mutex);
+							entries[index].type = EntryType::Duplicate;
+							entries[index].target = candidate.index;
+							release();
+							return;
+						}
+
+						if (size > 0 && !reused) encodeEntry(file.view(), encoded);
+					}
+					stored = reused ? previousArchive.subspan(previous->offset, previous->encodedSize) : std::span<const char>(encoded);
+
+					if (reused && size > 0)
+					{
+						std::vector<ContentOwner> candidates;
+						{
+							std::lock_guard<std::mutex> lock(mutex);
+
+							// Files that shared contents in the previous archive keep sharing them.
+							auto [owner, inserted] = entryOfPreviousOffset.try_emplace(previous->offset, index);
+							if (!inserted)
+							{
+								entries[index].type = EntryType::Duplicate;
+								entries[index].target = owner->second;
+								release();
+								return;
+							}
+
+							std::vector<ContentOwner>& owners = filesByContent[ContentKey(size, checksum)];
+							candidates = owners;
+							owners.push_back({ index, filePath });
+						}
+
+						// A file compressed again may now hold the same contents, only then is this one read.
+						if (!candidates.empty())
+						{
+							MappedFile file(filePath);
+							for (const ContentOwner& candidate : candidates)
+							{
+								if (!SameContents(candidate.filePath, file.view())) continue;
+
+								std::lock_guard<std::mutex> lock(mutex);
+								entries[index].type = EntryType::Duplicate;
+								entries[index].target = candidate.index;
+								release();
+								return;
+							}
+						}
+					}
+
+					std::lock_guard<std::mutex> lock(mutex);
+					ScopedTimer writeTimer(Phase::WriteOutput);
+					output.write(stored.data(), stored.size());
+					entries[index].size = size;
+					entries[index].offset = outputOffset;
+					entries[index].encodedSize = stored.size();
+					entries[index].checksum = checksum;
+					outputOffset += stored.size();
+					release();
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					release();
+					throw;
+				}
+			});
+		}
+		if (error) throw CompressionException("Error loading: " + folderPath);
+		pool.wait();
+
+		// A file matched by another while being found a duplicate itself passes the reference on.
+		for (ArchiveEntry& entry : entries)
+		{
+			if (entry.type != EntryType::Duplicate) continue;
+			while (entries[entry.target].type == EntryType::Duplicate) entry.target = entries[entry.target].target;
+		}
+
+		std::vector<char> directory;
+		WriteVarint(directory, dictionary.size());
+		directory.insert(directory.end(), dictionary.begin(), dictionary.end());
+		WriteVarint(directory, entries.size());
+		for (const ArchiveEntry& entry : entries)
+		{
+			directory.push_back(static_cast<char>(entry.type));
+			WriteVarint(directory, entry.path.size());
+			directory.insert(directory.end(), entry.path.begin(), entry.path.end());
+			if (entry.type == EntryType::Directory) continue;
+
+			if (entry.type == EntryType::Duplicate)
+			{
+				WriteVarint(directory, entry.target);
+			}
+			else
+			{
+				WriteVarint(directory, entry.size);
+				WriteVarint(directory, entry.offset);
+				WriteVarint(directory, entry.encodedSize);
+				WriteLE(directory, entry.checksum, 4);
+			}
+			WriteLE(directory, static_cast<std::uint64_t>(entry.modifiedTime), 8);
+		}
+		WriteLE(directory, Crc32(directory), 4);
+		WriteLE(directory, outputOffset, 8);
+
+		ScopedTimer writeTimer(Phase::WriteOutput);
+		output.write(directory.data(), directory.size());
+		if (!output) throw CompressionException("Error writing archive");
+	}
+
+	/**
+	* @brief Checks the version and directory checksum of an archive, returns the directory's offset.
+	*
+	* The directory ends at size - kTrailerSize. It starts with the dictionary, whose position
+	* is stored in dictionary.
+	*/
+	static std::size_t CheckedDirectory(const char* data, std::size_t size, std::span<const char>& dictionary)
+	{
+		if (!IsArchive({ data, size })) throw CompressionException("Invalid data format");
+		std::uint8_t version = static_cast<std::uint8_t>(data[1]);
+		if (version != kArchiveVersion) throw CompressionException("Unsupported format version");
+
+		std::size_t directoryEnd = size - kTrailerSize;
+		std::uint64_t directoryOffset = ReadLE(data + directoryEnd + 4, 8);
+		if (directoryOffset < 2 || directoryOffset >= directoryEnd) throw CompressionException("Invalid data format");
+		if (Crc32({ data + directoryOffset, directoryEnd - directoryOffset }) != ReadLE(data + directoryEnd, 4)) throw CompressionException("Archive directory checksum mismatch");
+
+		std::size_t offset = directoryOffset;
+		std::uint64_t dictionarySize = ReadVarint(data, directoryEnd, offset);
+		if (dictionarySize > directoryEnd - offset) throw CompressionException("Invalid data format");
+		dictionary = { data + offset, static_cast<std::size_t>(dictionarySize) };
+		return directoryOffset;
+	}
+
+	std::span<const char> ReadArchiveDictionary(const char* data, std::size_t size)
+	{
+		std::span<const char> dictionary;
+		CheckedDirectory(data, size, dictionary);
+		return dictionary;
+	}
+
+	std::vector<ArchiveEntry> ReadArchiveDirectory(const char* data, std::size_t size)
+	{
+		std::span<const char> dictionary;
+		std::size_t directoryOffset = CheckedDirectory(data, size, dictionary);
+		std::size_t directoryEnd = size - kTrailerSize;
+
+		std::size_t offset = dictionary.data() + dictionary.size() - data;
+		std::uint64_t entryCount = ReadVarint(data, directoryEnd, offset);
+		if (entryCount > directoryEnd - offset) throw CompressionException("Invalid data format");
+
+		std::vector<ArchiveEntry> entries(entryCount);
+		for (ArchiveEntry& entry : entries)
+		{
+			if (offset >= directoryEnd) throw CompressionException("Invalid data format");
+			entry.type = static_cast<EntryType>(data[offset++]);
+			if (entry.type > EntryType::Duplicate) throw CompressionException("Invalid data format");
+
+			std::uint64_t pathSize = ReadVarint(data, directoryEnd, offset);
+			if (pathSize > directoryEnd - offset) throw CompressionException("Invalid data format");
+			entry.path.assign(data + offset, pathSize);
+			offset += pathSize;
+			if (!IsSafePath(entry.path)) throw CompressionException("Invalid entry path: " + entry.path);
+
+			entry.size = 0;
+			entry.offset = 0;
+			entry.encodedSize = 0;
+			entry.checksum = 0;
+			entry.target = 0;
+			entry.modifiedTime = 0;
+			if (entry.type == EntryType::Directory) continue;
+
+			if (entry.type == EntryType::Duplicate)
+			{
+				entry.target = ReadVarint(data, directoryEnd, offset);
+			}
+			else
+			{
+				entry.size = ReadVarint(data, directoryEnd, offset);
+				entry.offset = ReadVarint(data, directoryEnd, offset);
+				entry.encodedSize = ReadVarint(data, directoryEnd, offset);
+				if (directoryEnd - offset < 4) throw CompressionException("Invalid data format");
+				entry.checksum = static_cast<std::uint32_t>(ReadLE(data + offset, 4));
+				offset += 4;
+				if (entry.offset < 2 || entry.offset > directoryOffset || entry.encodedSize > directoryOffset - entry.offset)
+				{
+					throw CompressionException("Invalid data format");
+				}
+			}
+
+			if (directoryEnd - offset < 8) throw CompressionException("Invalid data format");
+			entry.modifiedTime = static_cast<std::int64_t>(ReadLE(data + offset, 8));
+			offset += 8;
+		}
+
+		for (ArchiveEntry& entry : entries)
+		{
+			if (entry.type != EntryType::Duplicate) continue;
+			if (entry.target >= entries.size() || entries[entry.target].type != EntryType::File) throw CompressionException("Invalid data format");
+
+			const ArchiveEntry& target = entries[entry.target];
+			entry.size = target.size;
+			entry.offset = target.offset;
+			entry.encodedSize = target.encodedSize;
+			entry.checksum = target.checksum;
+		}
+		return entries;
+	}
+
+	const ArchiveEntry* FindEntry(const std::vector<ArchiveEntry>& entries, const String& path)
+	{
+		String normalized = NormalizedPath(path);
+		for (const ArchiveEntry& entry : entries)
+		{
+			if (entry.path == normalized) return &entry;
+		}
+		return nullptr;
+	}
+
+	std::vector<char> DecodeEntry(const char* data, const ArchiveEntry& entry, const EntryDecoder& decodeEntry)
+	{
+		std::vector<char> decoded;
+		if (entry.encodedSize > 0) decodeEntry({ data + entry.offset, static_cast<std::size_t>(entry.encodedSize) }, decoded);
+		if (decoded.size() != entry.size) throw CompressionException("Invalid data format");
+		if (Crc32(decoded) != entry.checksum) throw CompressionException("Checksum mismatch: " + entry.path);
+		return decoded;
+	}
+
+	/**
+	* @brief One decoded file written to its path and the paths of its duplicates.
+	*/
+	struct ExtractJob
+	{
+		const ArchiveEntry* entry;
+
+		fs::path path;
+
+		std::vector<fs::path> duplicates;
+	};
+
+	void DecodeFolder(const char* data, std::size_t size, const String& folderPath, const ExtractOptions& options, const EntryDecoder& decodeEntry,
+		const String& directoryPath)
+	{
+		std::vector<ArchiveEntry> entries = ReadArchiveDirectory(data, size);
+
+		String prefix = NormalizedPath(directoryPath);
+		if (!prefix.empty())
+		{
+			const ArchiveEntry* directory = FindEntry(entries, prefix);
+			if (!directory || directory->type != EntryType::Directory) throw CompressionException("No such directory in archive: " + directoryPath);
+			prefix += '/';
+		}
+
+		fs::path root(folderPath);
+		CreateDirectories(root);
+
+		std::vector<ExtractJob> jobs;
+		std::unordered_map<std::size_t, std::size_t> jobOfEntry;
+		std::vector<std::size_t> duplicates;
+		for (std::size_t index = 0; index < entries.size(); index++)
+		{
+			const ArchiveEntry& entry = entries[index];
+			if (entry.path.compare(0, prefix.size(), prefix) != 0) continue;
+
+			fs::path path = root / fs::path(entry.path.substr(prefix.size()));
+			if (entry.type == EntryType::Directory)
+			{
+				CreateDirectories(path);
+				continue;
+			}
+
+			CreateDirectories(path.parent_path());
+			if (entry.type == EntryType::Duplicate)
+			{
+				duplicates.push_back(index);
+				continue;
+			}
+			jobOfEntry[index] = jobs.size();
+			jobs.push_back({ &entry, path, {} });
+		}
+
+		// Duplicates of an extracted file reuse its decoded contents, the others decode their target alone.
+		for (std::size_t index : duplicates)
+		{
+			fs::path path = root / fs::path(entries[index].path.substr(prefix.size()));
+			auto job = jobOfEntry.find(entries[index].target);
+			if (job != jobOfEntry.end())
+			{
+				jobs[job->second].duplicates.push_back(path);
+			}
+			else
+			{
+				jobOfEntry[entries[index].target] = jobs.size();
+				jobs.push_back({ &entries[index], path, {} });
+			}
+		}
+
+		auto extractFile = [&](std::size_t index)
+		{
+			const ExtractJob& job = jobs[index];
+			std::vector<char> decoded = DecodeEntry(data, *job.entry, decodeEntry);
+
+			ScopedTimer writeTimer(Phase::WriteOutput);
+			WriteFile(job.path.string(), decoded, options.preallocate);
+			for (const fs::path& duplicate : job.duplicates)
+			{
+				std::error_code error;
+				if (options.hardLinkDuplicates)
+				{
+					fs::remove(duplicate, error);
+					fs::create_hard_link(job.path, duplicate, error);
+					if (!error) continue;
+				}
+				WriteFile(duplicate.string(), decoded, options.preallocate);
+			}
+		};
+
+		if (options.threadCount > 1 && jobs.size() > 1)
+		{
+			ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(options.threadCount, jobs.size())));
+			pool.parallelFor(jobs.size(), extractFile);
+		}
+		else
+		{
+			for (std::size_t index = 0; index < jobs.size(); index++) extractFile(index);
+		}
+	}
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include "Core.h"
+#include <ostream>
+#include <span>
+
+namespace Core
+{
+	/**
+	* @brief First byte of a folder archive.
+	*
+	* Method id 0 is never registered, so this marker cannot start a stream of a method.
+	*/
+	constexpr std::uint8_t kArchiveMarker = 0x80;
+
+	/**
+	* @brief Version of the folder archive layout, the second byte of an archive.
+	*/
+	constexpr std::uint8_t kArchiveVersion = 1;
+
+	/**
+	* @brief Kind of an archive entry.
+	*/
+	enum class EntryType : std::uint8_t
+	{
+		File,
+		Directory,
+		/**< A file identical to another file entry, stored only as a reference to it. */
+		Duplicate
+	};
+
+	/**
+	* @brief One file or directory recorded in the central directory of an archive.
+	*
+	* A duplicate carries the size, offset, encoded size and checksum of its target, so it
+	* decodes like the target itself.
+	*/
+	struct ArchiveEntry
+	{
+		/**< Path relative to the archived folder, with '/' separators. */
+		String path;
+
+		EntryType type;
+
+		/**< Size of the original file. */
+		std::uint64_t size;
+
+		/**< Position of the encoded file in the archive. */
+		std::uint64_t offset;
+
+		/**< Size of the encoded file, 0 for empty files. */
+		std::uint64_t encodedSize;
+
+		/**< Crc32 of the original file. */
+		std::uint32_t checksum;
+
+		/**< Index of the file entry holding the contents of a duplicate. */
+		std::uint64_t target;
+
+		/**< Last write time of the file in nanoseconds of the file clock, 0 if unknown. */
+		std::int64_t modifiedTime;
+	};
+
+	/**
+	* @brief Options of extracting an archive.
+	*/
+	struct ExtractOptions
+	{
+		/**< Number of files decoded in parallel. */
+		unsigned threadCount = 1;
+
+		/**< Preallocate every file before writing it, see WriteFile. */
+		bool preallocate = false;
+
+		/**< Create duplicates as hard links to their target instead of copies, where the file system allows. */
+		bool hardLinkDuplicates = false;
+	};
+
+	/**
+	* @brief Compresses the contents of one file, appending the result to the output vector.
+	*
+	* The encoded entry must start with the marker of the method that wrote it. Called from
+	* several threads at once.
+	*/
+	using EntryEncoder = std::function<void(std::span<const char> data, std::vector<char>& encodedData)>;
+
+	/**
+	* @brief Decompresses one entry written by an EntryEncoder, appending the result to the output vector.
+	*
+	* Called from several threads at once.
+	*/
+	using EntryDecoder = std::function<void(std::span<const char> encodedData, std::vector<char>& data)>;
+
+	/**
+	* @brief Returns true if data starts like a folder archive written by EncodeFolder.
+	*/
+	bool IsArchive(std::span<const char> data);
+
+	/**
+	* @brief Archives a folder, compressing every file independently on a pool of threads.
+	*
+	* The folder is traversed on the calling thread, which hands each file to the pool. Files
+	* are mapped, compressed and appended to the output in the order they finish, then the
+	* central directory recording every entry's offset is written after them. Files being
+	* compressed may hold at most memoryBudget bytes together, a larger file waits until it
+	* is the only one.
+	*
+	* Files with the same size and Crc32 as an earlier one are compared byte by byte with it,
+	* an identical file is not compressed and becomes a Duplicate entry.
+	*
+	* Given a previous archive of the folder, a file whose path, size and modification time
+	* match its entry there is not read, its encoded bytes are copied from the previous
+	* archive. So is a file of a new time whose size and Crc32 still match. Only new and
+	* changed files are compressed. Files are only taken from a previous archive holding the
+	* same dictionary, as their encoding may depend on it.
+	*
+	* The dictionary is opaque data the entry encoder shares between all files, such as a
+	* trained code table, stored once in the directory for the decoder, see ReadArchiveDictionary.
+	*
+	* Layout: kArchiveMarker, kArchiveVersion, the encoded files, the central directory
+	* (varint dictionary size and the dictionary, varint entry count, then per entry its
+	* type byte, varint path length, path and, for files, varint size, offset and encoded
+	* size and the 32-bit little-endian Crc32 of the original file, for duplicates, the
+	* varint index of their target, then for both the 64-bit little-endian modification
+	* time) and a trailer of the directory's 32-bit Crc32 and 64-bit offset, both
+	* little-endian. Reading the directory touches only the end of the archive.
+	*
+	* @param folderPath The folder to archive.
+	* @param output The stream receiving the archive, written sequentially from its current position.
+	* @param threadCount Number of files compressed in parallel.
+	* @param memoryBudget Largest total size of the files being compressed at once.
+	* @param encodeEntry Function compressing one file.
+	* @param previousArchive An earlier archive of the folder to take unchanged files from, empty for none.
+	*        It must stay valid until the function returns and must not be the output.
+	* @param dictionary Data the entries were encoded with, empty for none.
+	*
+	* @throw CompressionException if the folder cannot be read, the previous archive is malformed or the output cannot be written.
+	*/
+	void EncodeFolder(const String& folderPath, std::ostream& output, unsigned threadCount, std::size_t memoryBudget, const EntryEncoder& encodeEntry,
+		std::span<const char> previousArchive = {}, std::span<const char> dictionary = {});
+
+	/**
+	* @brief Reads the central directory of an archive written by EncodeFolder.
+	*
+	* @throw CompressionException if the archive is malformed, the directory checksum does not match or an entry path leaves the archived folder.
+	*/
+	std::vector<ArchiveEntry> ReadArchiveDirectory(const char* data, std::size_t size);
+
+	/**
+	* @brief Returns the dictionary stored in an archive written by EncodeFolder, empty if it has none.
+	*
+	* The result points into the archive. The entries are not parsed.
+	*
+	* @throw CompressionException if the archive is malformed or the directory checksum does not match.
+	*/
+	std::span<const char> ReadArchiveDictionary(const char* data, std::size_t size);
+
+	/**
+	* @brief Returns the entry stored under a path, or nullptr.
+	*
+	* @param entries The central directory.
+	* @param path Path relative to the archived folder, '/' or '\\' separated, a trailing separator is ignored.
+	*/
+	const ArchiveEntry* FindEntry(const std::vector<ArchiveEntry>& entries, const String& path);
+
+	/**
+	* @brief Decodes one file or duplicate entry of an archive and verifies its checksum.
+	*
+	* Only the entry's own bytes are read, so extracting one file does not touch the rest of the archive.
+	*
+	* @throw CompressionException if the entry is corrupted.
+	*/
+	std::vector<char> DecodeEntry(const char* data, const ArchiveEntry& entry, const EntryDecoder& decodeEntry);
+
+	/**
+	* @brief Extracts an archive written by EncodeFolder into a folder, decoding files in parallel.
+	*
+	* With a directory path given, only the entries under that directory are extracted, into
+	* folderPath itself. Contents shared by duplicates are decoded once.
+	*
+	* @param data The archive.
+	* @param size The size of the archive.
+	* @param folderPath The folder receiving the entries, created if missing.
+	* @param options Threads and file creation options.
+	* @param decodeEntry Function decompressing one file.
+	* @param directoryPath Directory entry to extract, empty for the whole archive.
+	*
+	* @throw CompressionException if the archive is malformed, a checksum does not match or a file cannot be written.
+	*/
+	void DecodeFolder(const char* data, std::size_t size, const String& folderPath, const ExtractOptions& options, const EntryDecoder& decodeEntry,
+		const String& directoryPath = "");
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+namespace Core
+{
+	/**
+	* @brief Loads 8 bytes stored in little-endian order.
+	*
+	* @param src Pointer to at least 8 readable bytes.
+	* @return The loaded 64-bit value.
+	*/
+	inline std::uint64_t LoadLE64(const std::uint8_t* src)
+	{
+		std::uint64_t value;
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			std::memcpy(&value, src, sizeof(value));
+		}
+		else
+		{
+			value = 0;
+			for (int i = 0; i < 8; i++) value |= static_cast<std::uint64_t>(src[i]) << (i * 8);
+		}
+		return value;
+	}
+
+	/**
+	* @brief Stores a 64-bit value as 8 bytes in little-endian order.
+	*
+	* @param dst Pointer to at least 8 writable bytes.
+	* @param value The value to store.
+	*/
+	inline void StoreLE64(std::uint8_t* dst, std::uint64_t value)
+	{
+		if constexpr (std::endian::native == std::endian::little)
+		{
+			std::memcpy(dst, &value, sizeof(value));
+		}
+		else
+		{
+			for (int i = 0; i < 8; i++) dst[i] = static_cast<std::uint8_t>(value >> (i * 8));
+		}
+	}
+
+	/**
+	* @brief Writes a bitstream LSB-first through a 64-bit accumulator.
+	*
+	* Bits are collected in the accumulator and flushed as whole words, so the
+	* destination must have 8 bytes of slack past the last byte written.
+	*/
+	class BitWriter
+	{
+	public:
+		/**
+		* @brief Constructs a writer storing bits starting at data.
+		*/
+		explicit BitWriter(std::uint8_t* data) : begin(data), current(data), buffer(0), bitCount(0) {}
+
+		/**
+		* @brief Appends count bits to the accumulator.
+		*
+		* At most 56 bits may be written between two calls to flush().
+		*/
+		inline void write(std::uint64_t bits, int count)
+		{
+			buffer |= bits << bitCount;
+			bitCount += count;
+		}
+
+		/**
+		* @brief Moves all whole bytes from the accumulator to the destination.
+		*/
+		inline void flush()
+		{
+			StoreLE64(current, buffer);
+			current += bitCount >> 3;
+			buffer >>= bitCount & ~7;
+			bitCount &= 7;
+		}
+
+		/**
+		* @brief Flushes the remaining bits, padding the last byte with zeros.
+		*
+		* @return The number of bytes written.
+		*/
+		inline std::size_t finish()
+		{
+			flush();
+			if (bitCount > 0)
+			{
+				*current++ = static_cast<std::uint8_t>(buffer);
+				buffer = 0;
+				bitCount = 0;
+			}
+			return static_cast<std::size_t>(current - begin);
+		}
+
+	private:
+		std::uint8_t* begin;
+
+		std::uint8_t* current;
+
+		std::uint64_t buffer;
+
+		int bitCount;
+	};
+
+	/**
+	* @brief Reads a bitstream LSB-first through a 64-bit bit buffer.
+	*
+	* Bits are consumed in the same order in which the encoder stores them:
+	* bit 0 of every byte first. The reader never touches memory past the end
+	* of the input, bits requested beyond the end are read as zeros and can be
+	* detected with position().
+	*/
+	class BitReader
+	{
+	public:
+		/**
+		* @brief Constructs a reader over a byte range.
+		*
+		* @param data Pointer to the first byte of the bitstream.
+		* @param size Number of bytes in the bitstream.
+		*/
+		BitReader(const std::uint8_t* data, std::size_t size)
+			: begin(data), current(data), end(data + size), buffer(0), bitCount(0), overrun(0) {}
+
+		/**
+		* @brief Tops the bit buffer up to at least 56 bits.
+		*/
+		inline void refill()
+		{
+			if (end - current >= 8)
+			{
+				buffer |= LoadLE64(current) << bitCount;
+				current += (63 - bitCount) >> 3;
+				bitCount |= 56;
+			}
+			else
+			{
+				while (bitCount <= 56)
+				{
+					if (current < end) buffer |= static_cast<std::uint64_t>(*current++) << bitCount;
+					else ++overrun;
+					bitCount += 8;
+				}
+			}
+		}
+
+		/**
+		* @brief Returns the next count bits without consuming them, count must be lower than 64.
+		*/
+		inline std::uint64_t peek(int count) const
+		{
+			return buffer & ((std::uint64_t(1) << count) - 1);
+		}
+
+		/**
+		* @brief Drops count bits from the bit buffer.
+		*/
+		inline void consume(int count)
+		{
+			buffer >>= count;
+			bitCount -= count;
+		}
+
+		/**
+		* @brief Reads count bits (at most 56) from the stream.
+		*/
+		inline std::uint64_t readBits(int count)
+		{
+			refill();
+			std::uint64_t value = peek(count);
+			consume(count);
+			return value;
+		}
+
+		/**
+		* @brief Returns the number of bits consumed so far.
+		*/
+		inline std::size_t position() const
+		{
+			return static_cast<std::size_t>(current - begin + overrun) * 8 - bitCount;
+		}
+
+		/**
+		* @brief Returns true if more bits were consumed than the input holds.
+		*/
+		inline bool overflowed() const
+		{
+			return position() > static_cast<std::size_t>(end - begin) * 8;
+		}
+
+	private:
+		const std::uint8_t* begin;
+
+		const std::uint8_t* current;
+
+		const std::uint8_t* end;
+
+		std::uint64_t buffer;
+
+		int bitCount;
+
+		std::size_t overrun;
+	};
+}
@@ -0,0 +1,427 @@
+#include "BlockContainer.h"
+#include "Pipeline.h"
+#include "Stats.h"
+#include "ThreadPool.h"
+
+#include <istream>
+#include <ostream>
+#include <span>
+
+namespace Core
+{
+	static void WriteLE32(std::vector<char>& data, std::uint32_t value)
+	{
+		for (int offset = 0; offset < 4; offset++) data.push_back(static_cast<char>((value >> (offset * 8)) & 0xFF));
+	}
+
+	static void WriteLE32(std::ostream& output, std::uint32_t value)
+	{
+		char bytes[4];
+		for (int offset = 0; offset < 4; offset++) bytes[offset] = static_cast<char>((value >> (offset * 8)) & 0xFF);
+		output.write(bytes, 4);
+	}
+
+	static std::uint32_t ReadLE32(const char* data)
+	{
+		std::uint32_t value = 0;
+		for (int offset = 0; offset < 4; offset++) value |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(data[offset])) << (offset * 8);
+		return value;
+	}
+
+	static std::uint32_t ReadLE32(std::istream& input)
+	{
+		char bytes[4];
+		if (!input.read(bytes, 4)) throw CompressionException("Invalid data format");
+		return ReadLE32(bytes);
+	}
+
+	/**
+	* @brief Reads one byte of every page, so the page faults of a mapped input are taken on the calling thread.
+	*
+	* The reader stage of a pipeline touches the blocks ahead of the workers, which then find
+	* them in memory instead of stalling on the disk.
+	*/
+	static void TouchPages(std::span<const char> data)
+	{
+		constexpr std::size_t kPageSize = 4096;
+
+		volatile char sink = 0;
+		for (std::size_t offset = 0; offset < data.size(); offset += kPageSize) sink = sink + data[offset];
+	}
+
+	static std::size_t BlocksInFlight(std::size_t blockSize, std::size_t memoryBudget)
+	{
+		return std::max<std::size_t>(1, memoryBudget / (2 * blockSize));
+	}
+
+	void EncodeBlocks(std::uint8_t marker, std::uint8_t flags, const char* data, std::size_t dataSize, std::size_t blockSize,
+		unsigned threadCount, const BlockEncoder& encodeBlock, std::vector<char>& encodedData)
+	{
+		if (blockSize == 0 || blockSize > kMaxBlockSize) throw CompressionException("Invalid block size");
+
+		std::size_t blockCount = (dataSize + blockSize - 1) / blockSize;
+		std::vector<std::vector<char>> encodedBlocks(blockCount);
+
+		auto compressBlock = [&](std::size_t block)
+		{
+			std::size_t rawOffset = block * blockSize;
+			std::size_t rawSize = std::min(blockSize, dataSize - rawOffset);
+
+			BlockTimer timer(rawSize);
+			encodeBlock(data + rawOffset, rawSize, encodedBlocks[block]);
+			timer.stop(encodedBlocks[block].size());
+			if (encodedBlocks[block].empty() || encodedBlocks[block].size() > UINT32_MAX) throw CompressionException("Invalid encoded block size");
+		};
+
+		if (threadCount > 1 && blockCount > 1)
+		{
+			ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(threadCount, blockCount)));
+			pool.parallelFor(blockCount, compressBlock);
+		}
+		else
+		{
+			for (std::size_t block = 0; block < blockCount; block++) compressBlock(block);
+		}
+
+		std::size_t totalSize = 0;
+		for (const std::vector<char>& block : encodedBlocks) totalSize += block.size() + 4;
+		encodedData.reserve(encodedData.size() + totalSize + 16 + blockCount * 4);
+
+		encodedData.push_back(static_cast<char>(marker));
+		encodedData.push_back(static_cast<char>(flags));
+		WriteVarint(encodedData, blockSize);
+
+		for (const std::vector<char>& block : encodedBlocks)
+		{
+			WriteLE32(encodedData, static_cast<std::uint32_t>(block.size()));
+			encodedData.insert(encodedData.end(), block.begin(), block.end());
+		}
+		WriteLE32(encodedData, 0);
+
+		std::size_t indexOffset = encodedData.size();
+		WriteVarint(encodedData, blockCount);
+		WriteVarint(encodedData, dataSize);
+		for (const std::vector<char>& block : encodedBlocks) WriteVarint(encodedData, block.size());
+		WriteLE32(encodedData, static_cast<std::uint32_t>(encodedData.size() - indexOffset));
+	}
+
+	std::size_t ContainerBound(std::size_t dataSize, std::size_t blockSize, std::size_t blockOverhead)
+	{
+		std::size_t blockCount = (dataSize + blockSize - 1) / blockSize;
+		return 2 + kMaxVarintSize + blockCount * (4 + blockOverhead + kMaxVarintSize) + dataSize + 4 + 2 * kMaxVarintSize + 4;
+	}
+
+	BlockIndex ReadBlockIndex(const char* data, std::size_t size)
+	{
+		if (size < 7) throw CompressionException("Invalid data format");
+
+		BlockIndex index;
+		index.flags = static_cast<std::uint8_t>(data[1]);
+
+		std::size_t offset = 2;
+		index.blockSize = ReadVarint(data, size, offset);
+		if (index.blockSize == 0 || index.blockSize > kMaxBlockSize) throw CompressionException("Invalid block size");
+		std::size_t blocksOffset = offset;
+
+		std::size_t indexSize = ReadLE32(data + size - 4);
+		if (indexSize > size - 4 - blocksOffset) throw CompressionException("Invalid data format");
+
+		std::size_t indexEnd = size - 4;
+		offset = indexEnd - indexSize;
+		std::size_t blockCount = ReadVarint(data, indexEnd, offset);
+		index.originalSize = ReadVarint(data, indexEnd, offset);
+		std::size_t expectedBlocks = index.originalSize / index.blockSize + (index.originalSize % index.blockSize != 0);
+		if (blockCount != expectedBlocks || blockCount > indexSize)
+		{
+			throw CompressionException("Invalid data format");
+		}
+
+		index.blocks.resize(blockCount);
+		std::size_t blockOffset = blocksOffset;
+		for (std::size_t block = 0; block < blockCount; block++)
+		{
+			if (blockOffset + 4 > indexEnd) throw CompressionException("Invalid data format");
+
+			BlockEntry& entry = index.blocks[block];
+			entry.size = ReadVarint(data, indexEnd, offset);
+			entry.offset = blockOffset + 4;
+			entry.rawOffset = block * index.blockSize;
+			entry.rawSize = std::min(index.blockSize, index.originalSize - entry.rawOffset);
+
+			if (entry.size > indexEnd - entry.offset) throw CompressionException("Invalid data format");
+			if (ReadLE32(data + blockOffset) != entry.size) throw CompressionException("Block index does not match the blocks");
+			blockOffset = entry.offset + entry.size;
+		}
+		if (blockOffset + 4 != indexEnd - indexSize) throw CompressionException("Block index does not match the blocks");
+
+		return index;
+	}
+
+	void DecodeBlocks(const char* data, const BlockIndex& index, std::size_t offset, std::size_t length, char* output,
+		unsigned threadCount, const BlockDecoder& decodeBlock)
+	{
+		if (length == 0) return;
+		if (offset > index.originalSize || length > index.originalSize - offset) throw CompressionException("Range out of bounds");
+
+		std::size_t firstBlock = offset / index.blockSize;
+		std::size_t lastBlock = (offset + length - 1) / index.blockSize;
+		std::size_t blockCount = lastBlock - firstBlock + 1;
+
+		auto decompressBlock = [&](std::size_t i)
+		{
+			const BlockEntry& block = index.blocks[firstBlock + i];
+			std::size_t rangeBegin = std::max(offset, block.rawOffset);
+			std::size_t rangeEnd = std::min(offset + length, block.rawOffset + block.rawSize);
+
+			BlockTimer timer(block.size);
+			if (rangeBegin == block.rawOffset && rangeEnd == block.rawOffset + block.rawSize)
+			{
+				decodeBlock(data + block.offset, block.size, output + (block.rawOffset - offset), block.rawSize);
+			}
+			else
+			{
+				std::vector<char> scratch(block.rawSize);
+				decodeBlock(data + block.offset, block.size, scratch.data(), block.rawSize);
+				std::memcpy(output + (rangeBegin - offset), scratch.data() + (rangeBegin - block.rawOffset), rangeEnd - rangeBegin);
+			}
+			timer.stop(block.rawSize);
+		};
+
+		if (threadCount > 1 && blockCount > 1)
+		{
+			ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(threadCount, blockCount)));
+			pool.parallelFor(blockCount, decompressBlock);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < blockCount; i++) decompressBlock(i);
+		}
+	}
+
+	/**
+	* @brief Supplies the next block of input in the given slot and reports whether more input follows.
+	*/
+	using BlockSource = std::function<bool(std::size_t slot, std::span<const char>& block)>;
+
+	static void EncodeBlockPipeline(std::uint8_t marker, std::uint8_t singleBlockMarker, std::uint8_t flags, const BlockSource& readBlock, std::ostream& output,
+		std::size_t blockSize, unsigned threadCount, std::size_t slotCount, const BlockEncoder& encodeBlock)
+	{
+		std::vector<std::span<const char>> rawBlocks(slotCount);
+		std::vector<std::vector<char>> encodedBlocks(slotCount);
+
+		ScopedTimer readTimer(Phase::ReadInput);
+		bool moreInput = readBlock(0, rawBlocks[0]);
+		readTimer.stop();
+		if (!moreInput && singleBlockMarker != 0)
+		{
+			BlockTimer timer(rawBlocks[0].size());
+			encodeBlock(rawBlocks[0].data(), rawBlocks[0].size(), encodedBlocks[0]);
+			timer.stop(encodedBlocks[0].size());
+
+			ScopedTimer writeTimer(Phase::WriteOutput);
+			output.put(static_cast<char>(singleBlockMarker));
+			output.put(static_cast<char>(flags));
+			output.write(encodedBlocks[0].data(), encodedBlocks[0].size());
+			if (!output) throw CompressionException("Error writing output");
+			return;
+		}
+
+		std::vector<char> header;
+		header.push_back(static_cast<char>(marker));
+		header.push_back(static_cast<char>(flags));
+		WriteVarint(header, blockSize);
+		output.write(header.data(), header.size());
+
+		std::vector<std::size_t> blockSizes;
+		std::size_t originalSize = 0;
+		bool firstBlock = true;
+		auto nextBlock = [&](std::size_t slot)
+		{
+			// The first block, read above, is handed to the first slot, slot 0.
+			if (firstBlock)
+			{
+				firstBlock = false;
+				return true;
+			}
+			if (!moreInput) return false;
+
+			ScopedTimer timer(Phase::ReadInput);
+			moreInput = readBlock(slot, rawBlocks[slot]);
+			return true;
+		};
+		auto compressBlock = [&](std::size_t slot)
+		{
+			BlockTimer timer(rawBlocks[slot].size());
+			encodedBlocks[slot].clear();
+			encodeBlock(rawBlocks[slot].data(), rawBlocks[slot].size(), encodedBlocks[slot]);
+			timer.stop(encodedBlocks[slot].size());
+			if (encodedBlocks[slot].empty() || encodedBlocks[slot].size() > UINT32_MAX) throw CompressionException("Invalid encoded block size");
+		};
+		auto writeBlock = [&](std::size_t slot)
+		{
+			ScopedTimer timer(Phase::WriteOutput);
+			WriteLE32(output, static_cast<std::uint32_t>(encodedBlocks[slot].size()));
+			output.write(encodedBlocks[slot].data(), encodedBlocks[slot].size());
+			if (!output) throw CompressionException("Error writing output");
+			blockSizes.push_back(encodedBlocks[slot].size());
+			originalSize += rawBlocks[slot].size();
+		};
+		RunPipeline(slotCount, threadCount, nextBlock, compressBlock, writeBlock);
+		WriteLE32(output, 0);
+
+		std::vector<char> index;
+		WriteVarint(index, blockSizes.size());
+		WriteVarint(index, originalSize);
+		for (std::size_t size : blockSizes) WriteVarint(index, size);
+		output.write(index.data(), index.size());
+		WriteLE32(output, static_cast<std::uint32_t>(index.size()));
+		if (!output) throw CompressionException("Error writing output");
+	}
+
+	void EncodeBlockStream(std::uint8_t marker, std::uint8_t singleBlockMarker, std::uint8_t flags, std::istream& input, std::ostream& output,
+		std::size_t blockSize, unsigned threadCount, std::size_t memoryBudget, const BlockEncoder& encodeBlock)
+	{
+		if (blockSize == 0 || blockSize > kMaxBlockSize) throw CompressionException("Invalid block size");
+
+		std::size_t batchSize = BlocksInFlight(blockSize, memoryBudget);
+		std::vector<std::vector<char>> buffers(batchSize);
+
+		auto readBlock = [&](std::size_t slot, std::span<const char>& block)
+		{
+			std::vector<char>& buffer = buffers[slot];
+			buffer.resize(blockSize);
+			input.read(buffer.data(), blockSize);
+			buffer.resize(static_cast<std::size_t>(input.gcount()));
+			if (input.bad()) throw CompressionException("Error reading input");
+
+			block = buffer;
+			return buffer.size() == blockSize && input.peek() != std::char_traits<char>::eof();
+		};
+
+		EncodeBlockPipeline(marker, singleBlockMarker, flags, readBlock, output, blockSize, threadCount, batchSize, encodeBlock);
+	}
+
+	void EncodeBlockStream(std::uint8_t marker, std::uint8_t singleBlockMarker, std::uint8_t flags, std::span<const char> input, std::ostream& output,
+		std::size_t blockSize, unsigned threadCount, std::size_t memoryBudget, const BlockEncoder& encodeBlock)
+	{
+		if (blockSize == 0 || blockSize > kMaxBlockSize) throw CompressionException("Invalid block size");
+
+		std::size_t offset = 0;
+		auto readBlock = [&](std::size_t, std::span<const char>& block)
+		{
+			block = input.subspan(offset, std::min(blockSize, input.size() - offset));
+			offset += block.size();
+			TouchPages(block);
+			return offset < input.size();
+		};
+
+		std::size_t batchSize = std::max<std::size_t>(1, memoryBudget / blockSize);
+		EncodeBlockPipeline(marker, singleBlockMarker, flags, readBlock, output, blockSize, threadCount, batchSize, encodeBlock);
+	}
+
+	void DecodeBlockStream(std::istream& input, std::ostream& output, unsigned threadCount, std::size_t memoryBudget, std::size_t blockOverhead,
+		const BlockDecoder& decodeBlock)
+	{
+		std::size_t blockSize = ReadVarint(input);
+		if (blockSize == 0 || blockSize > kMaxBlockSize) throw CompressionException("Invalid block size");
+
+		std::size_t slotCount = BlocksInFlight(blockSize, memoryBudget);
+		std::vector<std::vector<char>> encodedBlocks(slotCount);
+		std::vector<std::vector<char>> rawBlocks(slotCount);
+
+		std::vector<std::size_t> blockSizes;
+		std::uint32_t nextSize = ReadLE32(input);
+		if (nextSize == 0) throw CompressionException("Invalid data format");
+
+		auto readBlock = [&](std::size_t slot)
+		{
+			if (nextSize == 0) return false;
+			// The frame size is untrusted, a block can never need more than this.
+			if (nextSize > blockSize + blockOverhead) throw CompressionException("Invalid data format");
+
+			ScopedTimer readTimer(Phase::ReadInput);
+			std::vector<char>& block = encodedBlocks[slot];
+			block.resize(nextSize);
+			if (!input.read(block.data(), nextSize)) throw CompressionException("Invalid data format");
+
+			blockSizes.push_back(nextSize);
+			rawBlocks[slot].resize(blockSize);
+			nextSize = ReadLE32(input);
+			if (nextSize != 0) return true;
+
+			// The size of the last block is only known from the index after it, which holds a varint
+			// per block, the block count and original size and its own 32-bit size.
+			std::size_t maxIndexSize = (blockSizes.size() + 2) * kMaxVarintSize + 4;
+			std::vector<char> index;
+			while (true)
+			{
+				int byte = input.get();
+				if (byte == std::char_traits<char>::eof()) break;
+				if (index.size() == maxIndexSize) throw CompressionException("Invalid data format");
+				index.push_back(static_cast<char>(byte));
+			}
+			if (index.size() < 4) throw CompressionException("Invalid data format");
+
+			std::size_t indexEnd = index.size() - 4;
+			if (ReadLE32(index.data() + indexEnd) != indexEnd) throw CompressionException("Invalid data format");
+
+			std::size_t offset = 0;
+			std::size_t blockCount = ReadVarint(index.data(), indexEnd, offset);
+			std::size_t originalSize = ReadVarint(index.data(), indexEnd, offset);
+			if (blockCount != blockSizes.size()) throw CompressionException("Block index does not match the blocks");
+			for (std::size_t size : blockSizes)
+			{
+				if (ReadVarint(index.data(), indexEnd, offset) != size) throw CompressionException("Block index does not match the blocks");
+			}
+
+			std::size_t lastOffset = (blockCount - 1) * blockSize;
+			if (originalSize <= lastOffset || originalSize - lastOffset > blockSize) throw CompressionException("Invalid data format");
+			rawBlocks[slot].resize(originalSize - lastOffset);
+			return true;
+		};
+		auto decompressBlock = [&](std::size_t slot)
+		{
+			BlockTimer timer(encodedBlocks[slot].size());
+			decodeBlock(encodedBlocks[slot].data(), encodedBlocks[slot].size(), rawBlocks[slot].data(), rawBlocks[slot].size());
+			timer.stop(rawBlocks[slot].size());
+		};
+		auto writeBlock = [&](std::size_t slot)
+		{
+			ScopedTimer writeTimer(Phase::WriteOutput);
+			output.write(rawBlocks[slot].data(), rawBlocks[slot].size());
+			if (!output) throw CompressionException("Error writing output");
+		};
+		RunPipeline(slotCount, threadCount, readBlock, decompressBlock, writeBlock);
+	}
+
+	void DecodeBlockStream(const char* data, const BlockIndex& index, std::ostream& output, unsigned threadCount, std::size_t memoryBudget, const BlockDecoder& decodeBlock)
+	{
+		std::size_t slotCount = BlocksInFlight(index.blockSize, memoryBudget);
+		std::vector<std::size_t> blockOfSlot(slotCount);
+		std::vector<std::vector<char>> rawBlocks(slotCount);
+
+		std::size_t nextBlock = 0;
+		auto readBlock = [&](std::size_t slot)
+		{
+			if (nextBlock == index.blocks.size()) return false;
+
+			const BlockEntry& block = index.blocks[nextBlock];
+			TouchPages({ data + block.offset, block.size });
+			blockOfSlot[slot] = nextBlock++;
+			return true;
+		};
+		auto decompressBlock = [&](std::size_t slot)
+		{
+			const BlockEntry& block = index.blocks[blockOfSlot[slot]];
+			rawBlocks[slot].resize(block.rawSize);
+			DecodeBlocks(data, index, block.rawOffset, block.rawSize, rawBlocks[slot].data(), 1, decodeBlock);
+		};
+		auto writeBlock = [&](std::size_t slot)
+		{
+			ScopedTimer writeTimer(Phase::WriteOutput);
+			output.write(rawBlocks[slot].data(), rawBlocks[slot].size());
+			if (!output) throw CompressionException("Error writing output");
+		};
+		RunPipeline(slotCount, threadCount, readBlock, decompressBlock, writeBlock);
+	}
+}
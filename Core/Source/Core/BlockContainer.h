@@ -0,0 +1,203 @@
+#pragma once
+
+#include "Core.h"
+#include <functional>
+#include <span>
+
+namespace Core
+{
+	/**
+	* @brief Default amount of input compressed into one independent block.
+	*/
+	constexpr std::size_t kDefaultBlockSize = std::size_t(1) << 20;
+
+	/**
+	* @brief Largest supported block size, encoded blocks must fit the 32-bit frame size.
+	*/
+	constexpr std::size_t kMaxBlockSize = std::size_t(1) << 30;
+
+	/**
+	* @brief Default memory budget of the streaming encoder and decoder.
+	*/
+	constexpr std::size_t kDefaultMemoryBudget = std::size_t(256) << 20;
+
+	/**
+	* @brief Location of one block inside a block container.
+	*/
+	struct BlockEntry
+	{
+		/**< Offset of the encoded block from the start of the container. */
+		std::size_t offset;
+
+		/**< Size of the encoded block. */
+		std::size_t size;
+
+		/**< Offset of the block's data in the original input. */
+		std::size_t rawOffset;
+
+		/**< Size of the block's data in the original input. */
+		std::size_t rawSize;
+	};
+
+	/**
+	* @brief Parsed header and block index of a block container.
+	*/
+	struct BlockIndex
+	{
+		std::uint8_t flags;
+
+		std::size_t blockSize;
+
+		std::size_t originalSize;
+
+		std::vector<BlockEntry> blocks;
+	};
+
+	/**
+	* @brief Compresses one block, appending the encoded block to the output vector.
+	*/
+	using BlockEncoder = std::function<void(const char* data, std::size_t size, std::vector<char>& encodedBlock)>;
+
+	/**
+	* @brief Decompresses one block into an output buffer of exactly the block's original size.
+	*/
+	using BlockDecoder = std::function<void(const char* block, std::size_t blockSize, char* output, std::size_t outputSize)>;
+
+	/**
+	* @brief Splits the input into fixed-size blocks, compresses them independently and frames them.
+	*
+	* The container format:
+	* - 8 bits: format marker of the compression method
+	* - 8 bits: flags of the compression method
+	* - varint: block size
+	* - For each block:
+	*   - 32 bits: encoded block size
+	*   - The encoded block
+	* - 32 bits: 0, end of blocks
+	* - Block index:
+	*   - varint: number of blocks
+	*   - varint: size of the original data
+	*   - varint per block: encoded block size
+	* - 32 bits: size of the block index
+	*
+	* @param marker The format marker written as the first byte.
+	* @param flags The flags written as the second byte.
+	* @param data Pointer to the data to compress.
+	* @param dataSize The size of the data.
+	* @param blockSize Amount of input per block.
+	* @param threadCount Number of threads compressing blocks concurrently.
+	* @param encodeBlock Function compressing a single block.
+	* @param encodedData Vector to append the container to.
+	*/
+	void EncodeBlocks(std::uint8_t marker, std::uint8_t flags, const char* data, std::size_t dataSize, std::size_t blockSize,
+		unsigned threadCount, const BlockEncoder& encodeBlock, std::vector<char>& encodedData);
+
+	/**
+	* @brief Returns the largest size of a container written by EncodeBlocks.
+	*
+	* @param dataSize The size of the data.
+	* @param blockSize Amount of input per block.
+	* @param blockOverhead Largest number of bytes by which an encoded block may exceed its input.
+	*/
+	std::size_t ContainerBound(std::size_t dataSize, std::size_t blockSize, std::size_t blockOverhead);
+
+	/**
+	* @brief Reads the header and the block index of a container written by EncodeBlocks.
+	*
+	* @param data Pointer to the container.
+	* @param size The size of the container.
+	* @return The parsed index with the offsets of every block.
+	*
+	* @throw CompressionException if the container is malformed.
+	*/
+	BlockIndex ReadBlockIndex(const char* data, std::size_t size);
+
+	/**
+	* @brief Decompresses the blocks covering a byte range of the original data.
+	*
+	* Blocks are independent, so they are decoded concurrently straight into their slots
+	* in the output buffer. Only blocks partially covered by the range go through a scratch buffer.
+	*
+	* @param data Pointer to the container.
+	* @param index The index read by ReadBlockIndex.
+	* @param offset Offset of the range in the original data.
+	* @param length Length of the range, offset + length must not exceed the original size.
+	* @param output Buffer of length bytes receiving the range.
+	* @param threadCount Number of threads decoding blocks concurrently.
+	* @param decodeBlock Function decompressing a single block.
+	*/
+	void DecodeBlocks(const char* data, const BlockIndex& index, std::size_t offset, std::size_t length, char* output,
+		unsigned threadCount, const BlockDecoder& decodeBlock);
+
+	/**
+	* @brief Streaming counterpart of EncodeBlocks producing the same output.
+	*
+	* Blocks go through a RunPipeline: a reader thread reads them ahead, threadCount workers
+	* encode them and the calling thread writes them in order, so reading, encoding and
+	* writing overlap. The raw and encoded blocks in flight fit in memoryBudget, at least one
+	* block is always in flight. An input that ends within the first block is written as
+	* [singleBlockMarker][flags][block] instead of a container, unless singleBlockMarker is 0.
+	*
+	* @param marker The format marker of the container.
+	* @param singleBlockMarker The format marker of a single-block stream, 0 to always write a container.
+	* @param flags The flags written as the second byte.
+	* @param input The stream to compress.
+	* @param output The stream receiving the compressed data.
+	* @param blockSize Amount of input per block.
+	* @param threadCount Number of threads compressing blocks concurrently.
+	* @param memoryBudget Bytes available for blocks in flight.
+	* @param encodeBlock Function compressing a single block.
+	*
+	* @throw CompressionException if reading or writing fails.
+	*/
+	void EncodeBlockStream(std::uint8_t marker, std::uint8_t singleBlockMarker, std::uint8_t flags, std::istream& input, std::ostream& output,
+		std::size_t blockSize, unsigned threadCount, std::size_t memoryBudget, const BlockEncoder& encodeBlock);
+
+	/**
+	* @brief EncodeBlockStream over an input already in memory, such as a mapped file.
+	*
+	* Blocks are encoded straight from the input view, only the encoded blocks in flight are
+	* buffered, bounded by memoryBudget. The reader thread touches the pages of the blocks
+	* ahead, so the page faults of a mapped input are not taken by the workers.
+	*/
+	void EncodeBlockStream(std::uint8_t marker, std::uint8_t singleBlockMarker, std::uint8_t flags, std::span<const char> input, std::ostream& output,
+		std::size_t blockSize, unsigned threadCount, std::size_t memoryBudget, const BlockEncoder& encodeBlock);
+
+	/**
+	* @brief Streaming counterpart of DecodeBlocks.
+	*
+	* The input must be positioned right after the marker and flags bytes of a container.
+	* Blocks are read by a reader thread, decoded by threadCount workers and written in order
+	* by the calling thread, with the blocks in flight bounded by memoryBudget. The block
+	* index at the tail is only used to validate the blocks read. A block frame larger than
+	* the container's block size plus blockOverhead is rejected before it is allocated.
+	*
+	* @param input The stream positioned after the container's marker and flags.
+	* @param output The stream receiving the decompressed data.
+	* @param threadCount Number of threads decoding blocks concurrently.
+	* @param memoryBudget Bytes available for blocks in flight.
+	* @param blockOverhead Largest number of bytes by which an encoded block may exceed its input.
+	* @param decodeBlock Function decompressing a single block.
+	*
+	* @throw CompressionException if the container is malformed or reading or writing fails.
+	*/
+	void DecodeBlockStream(std::istream& input, std::ostream& output, unsigned threadCount, std::size_t memoryBudget, std::size_t blockOverhead,
+		const BlockDecoder& decodeBlock);
+
+	/**
+	* @brief DecodeBlockStream over a container already in memory, such as a mapped file.
+	*
+	* Blocks are decoded on threadCount workers while the calling thread writes the earlier
+	* ones in order, with the decoded blocks in flight bounded by memoryBudget.
+	*
+	* @param data Pointer to the container.
+	* @param index The index read by ReadBlockIndex.
+	* @param output The stream receiving the decompressed data.
+	* @param threadCount Number of threads decoding blocks concurrently.
+	* @param memoryBudget Bytes available for decoded blocks in flight.
+	* @param decodeBlock Function decompressing a single block.
+	*
+	* @throw CompressionException if a block is malformed or writing fails.
+	*/
+	void DecodeBlockStream(const char* data, const BlockIndex& index, std::ostream& output, unsigned threadCount, std::size_t memoryBudget, const BlockDecoder& decodeBlock);
+}
@@ -0,0 +1,46 @@
+#include "Checksum.h"
+
+#include <array>
+
+namespace Core
+{
+	static constexpr std::uint32_t kCrc32Polynomial = 0xEDB88320;
+
+	using Crc32Tables = std::array<std::array<std::uint32_t, 256>, 8>;
+
+	static Crc32Tables CreateCrc32Tables()
+	{
+		Crc32Tables tables{};
+		for (std::uint32_t byte = 0; byte < 256; byte++)
+		{
+			std::uint32_t crc = byte;
+			for (int bit = 0; bit < 8; bit++) crc = crc & 1 ? (crc >> 1) ^ kCrc32Polynomial : crc >> 1;
+			tables[0][byte] = crc;
+		}
+		for (std::size_t table = 1; table < 8; table++)
+		{
+			for (std::size_t byte = 0; byte < 256; byte++) tables[table][byte] = (tables[table - 1][byte] >> 8) ^ tables[0][tables[table - 1][byte] & 0xFF];
+		}
+		return tables;
+	}
+
+	std::uint32_t Crc32(std::span<const char> data, std::uint32_t crc)
+	{
+		static const Crc32Tables tables = CreateCrc32Tables();
+
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(data.data());
+		std::size_t size = data.size();
+		crc = ~crc;
+
+		for (; size >= 8; size -= 8, bytes += 8)
+		{
+			std::uint32_t low = crc ^ (bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<std::uint32_t>(bytes[3]) << 24);
+			std::uint32_t high = bytes[4] | bytes[5] << 8 | bytes[6] << 16 | static_cast<std::uint32_t>(bytes[7]) << 24;
+			crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24]
+				^ tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^ tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+		}
+		for (; size > 0; size--, bytes++) crc = (crc >> 8) ^ tables[0][(crc ^ *bytes) & 0xFF];
+
+		return ~crc;
+	}
+}
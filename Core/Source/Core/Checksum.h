@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Core.h"
+#include <span>
+
+namespace Core
+{
+	/**
+	* @brief Computes the CRC-32 (IEEE 802.3, as in zip and gzip) of data.
+	*
+	* Eight bytes are folded per step through eight lookup tables, over a GB/s on current hardware.
+	*
+	* @param data The data to checksum.
+	* @param crc The CRC of the preceding data when checksumming in pieces, 0 for the first piece.
+	* @return The CRC of the preceding data followed by data.
+	*/
+	std::uint32_t Crc32(std::span<const char> data, std::uint32_t crc = 0);
+}
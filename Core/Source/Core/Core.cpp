@@ -1,4 +1,12 @@
 #include "Core.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace Core {
 
@@ -8,101 +16,122 @@ namespace Core {
 	}
 
 
-	void ReadFile(const String& filepath, std::shared_ptr<char>& data, std::size_t& size)
+	std::size_t CompressionMethod::encode(std::span<const std::byte> data, std::span<std::byte> encodedData) const
 	{
-		std::ifstream plikIn;
-		plikIn.open(filepath, std::ios::binary);
-		if (plikIn.good())
-		{
-			plikIn.seekg(0, std::ios::end);
-			std::streampos fileSize = plikIn.tellg();
-			size = static_cast<std::size_t>(fileSize);
-			plikIn.seekg(0, std::ios::beg);
+		return createEncoder()->encode(data, encodedData);
+	}
 
-			data = std::shared_ptr<char>(new char[size], std::default_delete<char[]>());
+	std::size_t CompressionMethod::decode(std::span<const std::byte> encodedData, std::span<std::byte> data) const
+	{
+		return createDecoder()->decode(encodedData, data);
+	}
 
-			plikIn.read(data.get(), fileSize);
+	void CompressionMethod::encode(std::span<const char> data, std::vector<char>& encodedData) const
+	{
+		std::size_t outputOffset = encodedData.size();
+		encodedData.resize(outputOffset + compressBound(data.size()));
 
-			plikIn.close();
-		}
-		else throw CompressionException("Error loading: " + filepath);
+		std::size_t written = createEncoder()->encode(std::as_bytes(data), std::as_writable_bytes(std::span<char>(encodedData).subspan(outputOffset)));
+		encodedData.resize(outputOffset + written);
 	}
 
+	void CompressionMethod::decode(std::span<const char> dataToDecode, std::vector<char>& data) const
+	{
+		std::unique_ptr<DecoderContext> decoder = createDecoder();
+		std::size_t outputOffset = data.size();
+		data.resize(outputOffset + decoder->decodedSize(std::as_bytes(dataToDecode)));
 
+		std::size_t written = decoder->decode(std::as_bytes(dataToDecode), std::as_writable_bytes(std::span<char>(data).subspan(outputOffset)));
+		data.resize(outputOffset + written);
+	}
 
-	void ReadFile(const String& filepath, std::vector<std::bitset<8>>& data)
+	void CompressionMethod::decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const
 	{
-		std::ifstream file(filepath, std::ios::binary);
-		if (file)
-		{
-			file.seekg(0, std::ios::end);
-			std::streampos fileSize = file.tellg();
-			file.seekg(0, std::ios::beg);
+		std::vector<char> decoded;
+		decode(dataToDecode, decoded);
 
-			data.resize(fileSize);
-
-			char byte;
-			for (std::size_t i = 0; i < fileSize; ++i)
-			{
-				file.read(&byte, 1);
-				data[i] = std::bitset<8>(byte);
-			}
+		offset = std::min(offset, decoded.size());
+		length = std::min(length, decoded.size() - offset);
+		data.insert(data.end(), decoded.begin() + offset, decoded.begin() + offset + length);
+	}
 
-			file.close();
+	void WriteVarint(std::vector<char>& data, std::uint64_t value)
+	{
+		while (value >= 0x80)
+		{
+			data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+			value >>= 7;
 		}
-		else
+		data.push_back(static_cast<char>(value));
+	}
+
+	std::size_t WriteVarint(char* data, std::uint64_t value)
+	{
+		std::size_t size = 0;
+		while (value >= 0x80)
 		{
-			throw std::runtime_error("Error loading: " + filepath);
+			data[size++] = static_cast<char>((value & 0x7F) | 0x80);
+			value >>= 7;
 		}
+		data[size++] = static_cast<char>(value);
+		return size;
 	}
 
-	std::size_t readSubfolders(const fs::path& folderPath, String& folderStructure)
+	std::uint64_t ReadVarint(const char* data, std::size_t size, std::size_t& offset)
 	{
-		std::size_t startSize = folderStructure.length();
+		std::uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (offset >= size) throw CompressionException("Invalid data format");
+
+			std::uint8_t byte = static_cast<std::uint8_t>(data[offset++]);
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return value;
+		}
+		throw CompressionException("Invalid data format");
+	}
 
-		for (const auto& entry : fs::directory_iterator(folderPath))
+	std::uint64_t ReadVarint(std::istream& input)
+	{
+		std::uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
 		{
-			if (entry.is_directory())
-			{
-				folderStructure += entry.path().filename().string() + "\\*________";
-				std::size_t index = folderStructure.length() - 8;
-				std::size_t temp = readSubfolders(entry, folderStructure);
-				for (int offset = 0; offset < 8; offset++) folderStructure[index + offset] = static_cast<char>((temp >> (offset * 8)) & 0xFF);
+			int byte = input.get();
+			if (byte == std::char_traits<char>::eof()) throw CompressionException("Invalid data format");
 
-			}
-			else if (entry.is_regular_file())
-			{
-				String filename = entry.path().filename().string();
-				std::size_t size = 0;
-				std::shared_ptr<char> data;
-				ReadFile(entry.path().string(), data, size);
-
-				std::size_t temp = size;
-				String len = "________";
-				for (int offset = 0; offset < 8; offset++) len[offset] = static_cast<char>((temp >> (offset * 8)) & 0xFF);
- 
-				folderStructure += filename + "*" + len + String(data.get(), size);
-			}
+			value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return value;
 		}
-		return folderStructure.length() - startSize;
+		throw CompressionException("Invalid data format");
 	}
 
+	void ReadFile(const String& filepath, std::shared_ptr<char>& data, std::size_t& size)
+	{
+		auto file = std::make_shared<MappedFile>(filepath);
+		size = file->size();
+		data = std::shared_ptr<char>(file, const_cast<char*>(file->data()));
+	}
 
-	void ReadFolder(const String& folderPath, std::shared_ptr<char>& data, std::size_t& size)
+	void StreamFile(const String& inputPath, const String& outputPath, const std::function<void(std::istream&, std::ostream&)>& process)
 	{
-		String str = folderPath.substr(2);
-		str.erase(str.size());
-		str += "*________";
-		std::size_t index = str.length() - 8;
-		std::size_t temp = readSubfolders(folderPath, str);
-		for (int offset = 0; offset < 8; offset++) str[index + offset] = static_cast<char>((temp >> (offset * 8)) & 0xFF);
+		std::ifstream input(inputPath, std::ios::binary);
+		if (!input.good()) throw CompressionException("Error loading: " + inputPath);
 
-		
-		size = str.size();
-		char* newData = new char[size];
-		std::memcpy(newData, str.c_str(), size);
+		StreamFile(outputPath, [&](std::ostream& output)
+		{
+			process(input, output);
+		});
+	}
+
+	void StreamFile(const String& outputPath, const std::function<void(std::ostream&)>& process)
+	{
+		std::ofstream output(outputPath, std::ios::binary);
+		if (!output.good()) throw CompressionException("Error opening file:: " + outputPath);
 
-		data.reset(newData);
+		process(output);
+
+		output.close();
+		if (!output) throw CompressionException("Error writing file: " + outputPath);
 	}
 
 	void WriteFile(const String& filepath, std::shared_ptr<char>& data, std::size_t size)
@@ -121,69 +150,109 @@ namespace Core {
 	}
 
 	void WriteFile(const String& filepath, const std::vector<char>& data)
+	{
+		WriteFile(filepath, std::span<const char>(data), false);
+	}
+
+#ifdef _WIN32
+	void WriteFile(const String& filepath, std::span<const char> data, bool)
 	{
 		std::ofstream file(filepath, std::ios::out | std::ios::binary);
+		if (!file.is_open()) throw CompressionException("Error opening file:: " + filepath);
 
-		if (file.is_open()) {
-			file.write(data.data(), data.size());
-			file.close();
-		}
-		else throw CompressionException("Error opening file:: " + filepath);
+		file.write(data.data(), data.size());
+		file.close();
+		if (!file) throw CompressionException("Error writing file: " + filepath);
 	}
-
-	void WriteFile(const String& filepath, const std::vector<std::bitset<8>>& data)
+#else
+	void WriteFile(const String& filepath, std::span<const char> data, bool preallocate)
 	{
-		std::ofstream outputFile(filepath, std::ios::binary);
+		int file = open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+		if (file < 0) throw CompressionException("Error opening file:: " + filepath);
 
-		if (!outputFile.is_open()) {
-			throw std::runtime_error("Error opening file: " + filepath);
+		// Unsupported file systems return EOPNOTSUPP or EINVAL, the write then proceeds without it.
+		if (preallocate && !data.empty() && posix_fallocate(file, 0, static_cast<off_t>(data.size())) == ENOSPC)
+		{
+			close(file);
+			throw CompressionException("No space left for file: " + filepath);
 		}
 
-		for (const auto& bitset : data)
+		std::size_t written = 0;
+		while (written < data.size())
 		{
-			char byte = static_cast<char>(bitset.to_ulong());
-			outputFile.write(&byte, 1);
+			ssize_t result = write(file, data.data() + written, data.size() - written);
+			if (result < 0 && errno == EINTR) continue;
+			if (result <= 0)
+			{
+				close(file);
+				throw CompressionException("Error writing file: " + filepath);
+			}
+			written += static_cast<std::size_t>(result);
 		}
-
-		outputFile.close();
+		if (close(file) != 0) throw CompressionException("Error writing file: " + filepath);
 	}
+#endif
 
-	void WriteFolder(const String& path, std::vector<char>& contents)
+	/**
+	* @brief A file of a folder in the legacy folder format, viewing its contents in place.
+	*/
+	struct FolderFile
 	{
-		auto beginOfParcedChars = contents.begin();
-		auto endOfParcedChars = contents.end();
-		auto wsk = std::find(beginOfParcedChars, endOfParcedChars, '*');
-		String filepath;
+		String path;
 
-		while (wsk != endOfParcedChars)
+		std::span<const char> contents;
+	};
+
+	static void CollectFolder(const String& path, std::span<const char> contents, std::vector<FolderFile>& files)
+	{
+		std::size_t offset = 0;
+		while (true)
 		{
-			filepath = String(beginOfParcedChars, wsk);
-			if (wsk + 8 >= endOfParcedChars)throw CompressionException("Invalid folder compresion format");
-			String temp = String(wsk + 1,wsk + 9);
-			std::size_t parcedContedSize = 0;
+			auto separator = std::find(contents.begin() + offset, contents.end(), '*');
+			if (separator == contents.end()) break;
 
-			for (int offset = 0; offset < 8; offset++)
-			{
-				std::bitset<8> b(temp[offset]);
-				parcedContedSize |= b.to_ullong() << (offset * 8);
-			}
-			if (wsk + parcedContedSize + 8 >= endOfParcedChars) throw CompressionException("Index out of range ...");
+			std::size_t nameEnd = separator - contents.begin();
+			if (nameEnd + 9 > contents.size()) throw CompressionException("Invalid folder compresion format");
+
+			std::size_t size = 0;
+			for (int byte = 0; byte < 8; byte++) size |= static_cast<std::size_t>(static_cast<std::uint8_t>(contents[nameEnd + 1 + byte])) << (byte * 8);
+			if (size > contents.size() - nameEnd - 9) throw CompressionException("Index out of range ...");
+
+			bool isFolder = nameEnd > offset && contents[nameEnd - 1] == '\\';
+			String filepath = path + String(contents.data() + offset, nameEnd - offset);
+			std::span<const char> entry = contents.subspan(nameEnd + 9, size);
+			offset = nameEnd + 9 + size;
 
-			std::vector<char> parcedContent(wsk + 9, wsk + 9 + parcedContedSize);
-			beginOfParcedChars = wsk + 9 + parcedContedSize;
-			if (*(wsk - 1) == '\\')
+			if (isFolder)
 			{
-				fs::create_directory(path + filepath);
-				WriteFolder(path + filepath, parcedContent);
+				fs::create_directory(filepath);
+				CollectFolder(filepath, entry, files);
 			}
 			else
 			{
-				WriteFile(path + filepath, parcedContent);
+				files.push_back({ filepath, entry });
 			}
-
-			wsk = std::find(beginOfParcedChars, endOfParcedChars, '*');
 		}
+	}
+
+	void WriteFolder(const String& path, std::span<const char> contents, unsigned threadCount, bool preallocate)
+	{
+		std::vector<FolderFile> files;
+		CollectFolder(path, contents, files);
 
-	}	
-	
-}
\ No newline at end of file
+		auto writeFile = [&](std::size_t file)
+		{
+			WriteFile(files[file].path, files[file].contents, preallocate);
+		};
+
+		if (threadCount > 1 && files.size() > 1)
+		{
+			ThreadPool pool(static_cast<unsigned>(std::min<std::size_t>(threadCount, files.size())));
+			pool.parallelFor(files.size(), writeFile);
+		}
+		else
+		{
+			for (std::size_t file = 0; file < files.size(); file++) writeFile(file);
+		}
+	}
+}
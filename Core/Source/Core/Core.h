@@ -7,22 +7,150 @@
 #include <bitset>
 #include <vector>
 #include <string> 
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <span>
 
 #define fs std::filesystem
 #define String std::string
 
 namespace Core
 {
+	/**
+	* @brief Longest LEB128 encoding of a 64-bit value.
+	*/
+	constexpr std::size_t kMaxVarintSize = 10;
+
+	/**
+	* @brief Reusable encoder state created by CompressionMethod::createEncoder.
+	*
+	* A context keeps its tables and scratch buffers between calls, so encoding many inputs
+	* with one context does not allocate once its buffers have grown. A context must not be
+	* used by two threads at once.
+	*/
+	class EncoderContext {
+	public:
+		/**
+		* @brief Encodes data into a caller-provided buffer.
+		*
+		* @param data The data to encode.
+		* @param encodedData Buffer receiving the encoded data, compressBound(data.size()) bytes always suffice.
+		* @return The number of bytes written.
+		*
+		* @throw CompressionException if the buffer is too small or there is an error during encoding.
+		*/
+		virtual std::size_t encode(std::span<const std::byte> data, std::span<std::byte> encodedData) = 0;
+
+		virtual ~EncoderContext() {}
+	};
+
+	/**
+	* @brief Reusable decoder state created by CompressionMethod::createDecoder.
+	*
+	* Like EncoderContext, a context keeps its tables and scratch buffers between calls.
+	*/
+	class DecoderContext {
+	public:
+		/**
+		* @brief Returns the size of the data encoded in encodedData.
+		*
+		* @throw CompressionException if the data format is invalid.
+		*/
+		virtual std::size_t decodedSize(std::span<const std::byte> encodedData) = 0;
+
+		/**
+		* @brief Decodes encodedData into a caller-provided buffer of at least decodedSize(encodedData) bytes.
+		*
+		* @return The number of bytes written.
+		*
+		* @throw CompressionException if the buffer is too small or there is an error during decoding.
+		*/
+		virtual std::size_t decode(std::span<const std::byte> encodedData, std::span<std::byte> data) = 0;
+
+		virtual ~DecoderContext() {}
+	};
+
 	/**
 	* @brief An interface to compression methods.
 	*/
 	class CompressionMethod {
 	public:
-		virtual void encode(const std::shared_ptr<char>& data, std::size_t dataSize, std::vector<std::bitset<8>>& encodedData) const = 0;
-		virtual void decode(const std::vector<std::bitset<8>>& dataToDecode, std::vector<char>& data) const = 0;
+		/**
+		* @brief Returns the largest encoded size of dataSize bytes of input.
+		*/
+		virtual std::size_t compressBound(std::size_t dataSize) const = 0;
+
+		/**
+		* @brief Creates a reusable encoder context.
+		*/
+		virtual std::unique_ptr<EncoderContext> createEncoder() const = 0;
+
+		/**
+		* @brief Creates a reusable decoder context.
+		*/
+		virtual std::unique_ptr<DecoderContext> createDecoder() const = 0;
+
+		/**
+		* @brief Encodes data into a caller-provided buffer through a temporary context.
+		*
+		* @return The number of bytes written.
+		*/
+		std::size_t encode(std::span<const std::byte> data, std::span<std::byte> encodedData) const;
+
+		/**
+		* @brief Decodes data into a caller-provided buffer through a temporary context.
+		*
+		* @return The number of bytes written.
+		*/
+		std::size_t decode(std::span<const std::byte> encodedData, std::span<std::byte> data) const;
+
+		/**
+		* @brief Encodes data, appending the result to a vector.
+		*/
+		void encode(std::span<const char> data, std::vector<char>& encodedData) const;
+
+		/**
+		* @brief Decodes data, appending the result to a vector.
+		*/
+		void decode(std::span<const char> dataToDecode, std::vector<char>& data) const;
+
+		/**
+		* @brief Decodes only the bytes [offset, offset + length) of the original data.
+		*
+		* The range is clamped to the size of the original data. The default implementation
+		* decodes everything and keeps the range, methods with random access override it.
+		*/
+		virtual void decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const;
+
 		virtual ~CompressionMethod() {} // Wirtualny destruktor
 	};
 
+	/**
+	* @brief An interface to compression methods working on streams in bounded memory.
+	*
+	* Implementations process the input in fixed-size chunks, so the memory used does not
+	* depend on the size of the input and files larger than RAM can be processed.
+	*/
+	class StreamCompressionMethod {
+	public:
+		virtual void encodeStream(std::istream& input, std::ostream& output) const = 0;
+		virtual void decodeStream(std::istream& input, std::ostream& output) const = 0;
+
+		/**
+		* @brief Encodes an input already in memory, such as a mapped file, without copying it into block buffers.
+		*/
+		virtual void encodeStream(std::span<const char> input, std::ostream& output) const = 0;
+
+		/**
+		* @brief Decodes an input already in memory, such as a mapped file, writing the result in bounded chunks.
+		*/
+		virtual void decodeStream(std::span<const char> input, std::ostream& output) const = 0;
+
+		virtual ~StreamCompressionMethod() {}
+	};
+
 
 
 	/**
@@ -54,9 +182,49 @@ namespace Core
 		const char* what() const noexcept override;
 	};
 
+	/**
+	* @brief Appends an unsigned integer in LEB128 varint encoding.
+	*
+	* @param data The vector to append to.
+	* @param value The value to write.
+	*/
+	void WriteVarint(std::vector<char>& data, std::uint64_t value);
+
+	/**
+	* @brief Writes an unsigned integer in LEB128 varint encoding to a buffer of at least kMaxVarintSize bytes.
+	*
+	* @return The number of bytes written.
+	*/
+	std::size_t WriteVarint(char* data, std::uint64_t value);
+
+	/**
+	* @brief Reads an unsigned integer in LEB128 varint encoding.
+	*
+	* @param data Pointer to the buffer.
+	* @param size The size of the buffer.
+	* @param offset Position of the varint, advanced past it.
+	* @return The decoded value.
+	*
+	* @throw CompressionException if the buffer ends inside the varint.
+	*/
+	std::uint64_t ReadVarint(const char* data, std::size_t size, std::size_t& offset);
+
+	/**
+	* @brief Reads an unsigned integer in LEB128 varint encoding from a stream.
+	*
+	* @param input The stream to read from.
+	* @return The decoded value.
+	*
+	* @throw CompressionException if the stream ends inside the varint.
+	*/
+	std::uint64_t ReadVarint(std::istream& input);
+
 	/**
 	 * @brief Reads the contents of a file into a shared pointer to char array.
 	 *
+	 * Regular files are memory-mapped, the pointer then refers to the read-only mapping
+	 * and keeps it alive. Other files are read into a buffer.
+	 *
 	 * @param filepath The path to the file to be read.
 	 * @param data The shared pointer to char array to store the file data.
 	 * @param size Reference to store the size of the file.
@@ -66,31 +234,25 @@ namespace Core
 	void ReadFile(const String& filepath, std::shared_ptr<char>& data, std::size_t& size);
 
 	/**
-	* @brief Reads the contents of a file into a vector of bitsets.
-	*
-	* Each bitset contains 8 bits representing a byte from the file.
+	* @brief Opens an input and an output file and passes both streams to a processing function.
 	*
-	* @param filepath The path to the file to be read.
-	* @param data The vector of bitsets to store the file data.
+	* @param inputPath The path to the file to read.
+	* @param outputPath The path to the file to write.
+	* @param process Function reading the input stream and writing the output stream.
 	*
-	* @throw std::runtime_error if there is an error loading the file.
+	* @throw CompressionException if either file cannot be opened.
 	*/
-	void ReadFile(const String& filepath, std::vector<std::bitset<8>>& data);
-
-	std::size_t readSubfolders(const fs::path& folderPath, String& folderStructure);
+	void StreamFile(const String& inputPath, const String& outputPath, const std::function<void(std::istream&, std::ostream&)>& process);
 
 	/**
-	* @brief Reads the contents of a folder into a shared pointer to char array.
+	* @brief Opens an output file and passes the stream to a function writing it.
 	*
-	* This function constructs a string pattern representing the folder contents
-	* and stores it in the provided data pointer. Each character in the pattern
-	* represents a specific type of file or subfolder.
+	* @param outputPath The path to the file to write.
+	* @param process Function writing the output stream.
 	*
-	* @param folderPath The path to the folder to be read.
-	* @param data The shared pointer to char array to store the folder contents pattern.
-	* @param size Reference to store the size of the folder contents pattern.
+	* @throw CompressionException if the file cannot be opened or written.
 	*/
-	void ReadFolder(const String& folderPath, std::shared_ptr<char>& data, std::size_t& size);
+	void StreamFile(const String& outputPath, const std::function<void(std::ostream&)>& process);
 
 	/**
 	 * @brief Writes data from a shared pointer to a file.
@@ -114,28 +276,31 @@ namespace Core
 	void WriteFile(const String& filepath, const std::vector<char>& data);
 
 	/**
-	* @brief Writes data from a vector of bitsets to a file.
-	*
-	* Each bitset represents a byte in the file.
+	* @brief Writes a byte view to a file.
 	*
 	* @param filepath The path to the file to write.
-	* @param data The vector of bitsets to write.
+	* @param data The bytes to write.
+	* @param preallocate Reserve the file's blocks with posix_fallocate before writing, which
+	*        keeps large files contiguous and reports a full disk before any byte is written.
+	*        Ignored where the platform or file system does not support it.
 	*
-	* @throw std::runtime_error if there is an error opening the file.
+	* @throw CompressionException if the file cannot be opened or written.
 	*/
-	void WriteFile(const String& filepath, const std::vector<std::bitset<8>>& data);
+	void WriteFile(const String& filepath, std::span<const char> data, bool preallocate);
 
 	/**
-	* @brief Writes the contents of a folder recursively based on the provided contents.
+	* @brief Writes the contents of a folder serialized in the legacy folder format.
 	*
-	* This function parses the provided contents vector to reconstruct the folder structure
-	* and writes the contents of each file or subfolder to the specified path recursively.
+	* The contents are parsed in place, every file is a view into them. All directories are
+	* created first, then the files are written by a pool of threads.
 	*
 	* @param path The path to the folder where the contents will be written.
-	* @param contents The vector containing the compressed folder contents.
+	* @param contents The decoded folder contents.
+	* @param threadCount Number of threads writing files.
+	* @param preallocate Preallocate every file before writing it, see WriteFile.
 	*
 	* @throw CompressionException if there is an error in the folder compression format or writing files.
 	*/
-	void WriteFolder(const String& path, std::vector<char>& contents);
+	void WriteFolder(const String& path, std::span<const char> contents, unsigned threadCount = 1, bool preallocate = false);
 	
 }
\ No newline at end of file
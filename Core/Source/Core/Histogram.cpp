@@ -0,0 +1,148 @@
+#include "Histogram.h"
+#include "BitStream.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace Core
+{
+	static constexpr int kCountTables = 4;
+
+	/**< Bytes counted into 32-bit tables before they are added to the 64-bit totals. */
+	static constexpr std::size_t kCountChunkSize = std::size_t(1) << 30;
+
+	/**< Inputs shorter than this are counted directly, clearing and merging the tables would dominate. */
+	static constexpr std::size_t kSmallInputSize = 256;
+
+	using CountTables = std::uint32_t[kCountTables][256];
+
+	static inline void CountWord(std::uint64_t word, CountTables& tables)
+	{
+		tables[0][word & 0xFF]++;
+		tables[1][(word >> 8) & 0xFF]++;
+		tables[2][(word >> 16) & 0xFF]++;
+		tables[3][(word >> 24) & 0xFF]++;
+		tables[0][(word >> 32) & 0xFF]++;
+		tables[1][(word >> 40) & 0xFF]++;
+		tables[2][(word >> 48) & 0xFF]++;
+		tables[3][word >> 56]++;
+	}
+
+	static void CountInterleaved(const std::uint8_t* data, std::size_t size, CountTables& tables)
+	{
+		std::size_t i = 0;
+		for (; i + 16 <= size; i += 16)
+		{
+			std::uint64_t low = LoadLE64(data + i);
+			std::uint64_t high = LoadLE64(data + i + 8);
+
+			// A run of one value would hit the same counter 16 times, count it with a single add.
+			if (low == high && low == (low & 0xFF) * 0x0101010101010101ull)
+			{
+				tables[0][low & 0xFF] += 16;
+				continue;
+			}
+
+			CountWord(low, tables);
+			CountWord(high, tables);
+		}
+		for (; i < size; i++)
+		{
+			tables[0][data[i]]++;
+		}
+	}
+
+	void CountBytes(const std::uint8_t* data, std::size_t size, std::uint64_t* counts)
+	{
+		std::fill_n(counts, 256, 0);
+		if (size < kSmallInputSize)
+		{
+			for (std::size_t i = 0; i < size; i++) counts[data[i]]++;
+			return;
+		}
+
+		CountTables tables;
+		while (size > 0)
+		{
+			std::size_t chunk = std::min(size, kCountChunkSize);
+			std::fill_n(&tables[0][0], kCountTables * 256, 0);
+			CountInterleaved(data, chunk, tables);
+
+			for (int symbol = 0; symbol < 256; symbol++)
+			{
+				counts[symbol] += std::uint64_t(tables[0][symbol]) + tables[1][symbol] + tables[2][symbol] + tables[3][symbol];
+			}
+
+			data += chunk;
+			size -= chunk;
+		}
+	}
+
+	void CountBytes(const std::uint8_t* data, std::size_t size, std::uint64_t* counts, unsigned threadCount)
+	{
+		std::size_t chunkCount = std::min<std::size_t>(threadCount, size / kParallelHistogramSize);
+		if (chunkCount <= 1)
+		{
+			CountBytes(data, size, counts);
+			return;
+		}
+
+		std::size_t chunkSize = (size + chunkCount - 1) / chunkCount;
+		std::vector<std::array<std::uint64_t, 256>> partialCounts(chunkCount);
+
+		ThreadPool pool(static_cast<unsigned>(chunkCount));
+		pool.parallelFor(chunkCount, [&](std::size_t chunk)
+		{
+			std::size_t begin = chunk * chunkSize;
+			CountBytes(data + begin, std::min(chunkSize, size - begin), partialCounts[chunk].data());
+		});
+
+		std::fill_n(counts, 256, 0);
+		for (const std::array<std::uint64_t, 256>& partial : partialCounts)
+		{
+			for (int symbol = 0; symbol < 256; symbol++) counts[symbol] += partial[symbol];
+		}
+	}
+
+	std::size_t CountSample(const std::uint8_t* data, std::size_t size, std::uint64_t* counts)
+	{
+		if (size <= kSampleChunkCount * kSampleChunkSize)
+		{
+			CountBytes(data, size, counts);
+			return size;
+		}
+
+		std::fill_n(counts, 256, 0);
+
+		std::uint64_t chunkCounts[256];
+		std::size_t stride = (size - kSampleChunkSize) / (kSampleChunkCount - 1);
+		for (std::size_t chunk = 0; chunk < kSampleChunkCount; chunk++)
+		{
+			CountBytes(data + chunk * stride, kSampleChunkSize, chunkCounts);
+			for (int symbol = 0; symbol < 256; symbol++) counts[symbol] += chunkCounts[symbol];
+		}
+
+		return kSampleChunkCount * kSampleChunkSize;
+	}
+
+	double Entropy(const std::uint64_t* counts)
+	{
+		std::uint64_t total = 0;
+		for (int symbol = 0; symbol < 256; symbol++) total += counts[symbol];
+		if (total == 0) return 0;
+
+		double bits = 0;
+		for (int symbol = 0; symbol < 256; symbol++)
+		{
+			if (counts[symbol] == 0) continue;
+
+			double probability = static_cast<double>(counts[symbol]) / static_cast<double>(total);
+			bits -= probability * std::log2(probability);
+		}
+
+		return bits;
+	}
+}
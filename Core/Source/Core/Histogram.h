@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Core
+{
+	/**
+	* @brief Smallest amount of input per thread when counting in parallel.
+	*/
+	constexpr std::size_t kParallelHistogramSize = std::size_t(4) << 20;
+
+	/**
+	* @brief Counts the occurrences of every byte value.
+	*
+	* Consecutive bytes are spread over interleaved count tables, so runs of one value do not
+	* stall on stores to a single counter, and 16 equal bytes are counted with a single add.
+	*
+	* @param data Pointer to the data.
+	* @param size The size of the data.
+	* @param counts Array of 256 counters, overwritten with the counts.
+	*/
+	void CountBytes(const std::uint8_t* data, std::size_t size, std::uint64_t* counts);
+
+	/**
+	* @brief Counts the occurrences of every byte value, large inputs in chunks on threadCount threads.
+	*
+	* Inputs shorter than kParallelHistogramSize per thread are counted on the calling thread.
+	*/
+	void CountBytes(const std::uint8_t* data, std::size_t size, std::uint64_t* counts, unsigned threadCount);
+
+	/**
+	* @brief Number of evenly spaced chunks counted by CountSample.
+	*/
+	constexpr std::size_t kSampleChunkCount = 16;
+
+	/**
+	* @brief Size of one chunk counted by CountSample.
+	*/
+	constexpr std::size_t kSampleChunkSize = 1024;
+
+	/**
+	* @brief Counts the byte values of kSampleChunkCount chunks spread evenly over the data.
+	*
+	* Inputs no larger than the sample are counted whole.
+	*
+	* @param data Pointer to the data.
+	* @param size The size of the data.
+	* @param counts Array of 256 counters, overwritten with the counts.
+	* @return The number of bytes counted.
+	*/
+	std::size_t CountSample(const std::uint8_t* data, std::size_t size, std::uint64_t* counts);
+
+	/**
+	* @brief Returns the order-0 Shannon entropy of a histogram, in bits per byte.
+	*
+	* @param counts Array of 256 counters.
+	*/
+	double Entropy(const std::uint64_t* counts);
+}
@@ -1,272 +1,1114 @@
 #include "Huffman.h"
+#include "Checksum.h"
+#include "Stats.h"
 
 namespace Huffman
 {
-	HuffmanNode::HuffmanNode(char character, int weight) : character(character), weight(weight), left(nullptr), right(nullptr) {}
-
-	HuffmanNode::HuffmanNode(HuffmanNode* l, HuffmanNode* r) : character('\0'), weight(l->weight + r->weight), left(l), right(r) {}
-
-	HuffmanNode::HuffmanNode(const HuffmanNode& other) : character(other.character), weight(other.weight), left(nullptr), right(nullptr)
+	static std::size_t SortUsedSymbols(const std::uint64_t* counts, std::size_t alphabetSize, std::uint8_t* codeLengths, std::uint16_t* symbols)
 	{
-		if (other.left) {
-			left = new HuffmanNode(*other.left);
-		}
-		if (other.right) {
-			right = new HuffmanNode(*other.right);
+		std::size_t symbolCount = 0;
+		for (std::size_t symbol = 0; symbol < alphabetSize; symbol++)
+		{
+			codeLengths[symbol] = 0;
+			if (counts[symbol] != 0) symbols[symbolCount++] = static_cast<std::uint16_t>(symbol);
 		}
+
+		std::sort(symbols, symbols + symbolCount, [counts](std::uint16_t left, std::uint16_t right)
+		{
+			return counts[left] < counts[right] || (counts[left] == counts[right] && left < right);
+		});
+
+		return symbolCount;
 	}
 
-	void HuffmanNode::getLeaves(HuffmanNode* root, std::unordered_map<char, String>& huffmanaCode, String pom)
+	void HuffmanCodeLengths(const std::uint64_t* counts, std::size_t alphabetSize, std::uint8_t* codeLengths)
 	{
-		if (root == nullptr)
+		std::uint16_t symbols[kMaxAlphabetSize];
+		std::size_t symbolCount = SortUsedSymbols(counts, alphabetSize, codeLengths, symbols);
+
+		if (symbolCount == 0) return;
+		if (symbolCount == 1)
+		{
+			codeLengths[symbols[0]] = 1;
 			return;
+		}
+
+		std::uint64_t items[kMaxAlphabetSize];
+		for (std::size_t i = 0; i < symbolCount; i++) items[i] = counts[symbols[i]];
+
+		// Pairing pass: items[next] becomes the weight of the next internal node,
+		// the items it consumes are overwritten with a pointer to it.
+		const std::size_t n = symbolCount;
+		std::size_t root = 0;
+		std::size_t leaf = 2;
+		items[0] += items[1];
+		for (std::size_t next = 1; next < n - 1; next++)
+		{
+			if (leaf >= n || items[root] < items[leaf])
+			{
+				items[next] = items[root];
+				items[root++] = next;
+			}
+			else
+			{
+				items[next] = items[leaf++];
+			}
+
+			if (leaf >= n || (root < next && items[root] < items[leaf]))
+			{
+				items[next] += items[root];
+				items[root++] = next;
+			}
+			else
+			{
+				items[next] += items[leaf++];
+			}
+		}
+
+		// Internal node depths, the root is the last internal node.
+		items[n - 2] = 0;
+		for (std::size_t next = n - 2; next-- > 0;)
+		{
+			items[next] = items[items[next]] + 1;
+		}
+
+		// Leaf depths: every level has twice the internal nodes of the level above as slots,
+		// the slots not taken by internal nodes are leaves, assigned from the heaviest symbol down.
+		std::size_t available = 1;
+		std::size_t depth = 0;
+		std::ptrdiff_t internal = static_cast<std::ptrdiff_t>(n) - 2;
+		std::ptrdiff_t next = static_cast<std::ptrdiff_t>(n) - 1;
+		while (available > 0)
+		{
+			std::size_t used = 0;
+			while (internal >= 0 && items[internal] == depth)
+			{
+				used++;
+				internal--;
+			}
+			while (available > used)
+			{
+				items[next--] = depth;
+				available--;
+			}
 
-		if (!root->left && !root->right) {
-			huffmanaCode[root->character] = pom;
+			available = 2 * used;
+			depth++;
 		}
 
-		getLeaves(root->left, huffmanaCode, pom + "0");
-		getLeaves(root->right, huffmanaCode, pom + "1");
+		for (std::size_t i = 0; i < symbolCount; i++)
+		{
+			codeLengths[symbols[i]] = static_cast<std::uint8_t>(items[i]);
+		}
 	}
 
-	HuffmanNode::~HuffmanNode()
+	void PackageMergeCodeLengths(const std::uint64_t* counts, std::size_t alphabetSize, int maxLength, std::uint8_t* codeLengths)
 	{
-		delete left;
-		delete right;
-	};
+		std::uint16_t symbols[kMaxAlphabetSize];
+		std::size_t symbolCount = SortUsedSymbols(counts, alphabetSize, codeLengths, symbols);
+
+		if (symbolCount == 0) return;
+		if (symbolCount == 1)
+		{
+			codeLengths[symbols[0]] = 1;
+			return;
+		}
+		if (maxLength < 1 || maxLength > kMaxCodeLengthLimit || (std::size_t(1) << maxLength) < symbolCount)
+		{
+			throw Core::CompressionException("Code length limit too small for the alphabet");
+		}
+
+		constexpr std::size_t kMaxItems = 2 * kMaxAlphabetSize;
+		std::uint64_t list[kMaxItems];
+		std::uint64_t deeperList[kMaxItems];
+		std::size_t deeperCount = 0;
+		bool isLeaf[kMaxCodeLengthLimit][kMaxItems];
+
+		const std::size_t listLimit = 2 * symbolCount - 2;
+		for (int level = maxLength - 1; level >= 0; level--)
+		{
+			std::size_t leaf = 0;
+			std::size_t package = 0;
+			std::size_t packageCount = deeperCount / 2;
+			std::size_t itemCount = 0;
+
+			while (itemCount < listLimit && (leaf < symbolCount || package < packageCount))
+			{
+				std::uint64_t packageWeight = package < packageCount ? deeperList[2 * package] + deeperList[2 * package + 1] : 0;
+				if (package >= packageCount || (leaf < symbolCount && counts[symbols[leaf]] <= packageWeight))
+				{
+					list[itemCount] = counts[symbols[leaf++]];
+					isLeaf[level][itemCount++] = true;
+				}
+				else
+				{
+					list[itemCount] = packageWeight;
+					isLeaf[level][itemCount++] = false;
+					package++;
+				}
+			}
 
+			std::copy_n(list, itemCount, deeperList);
+			deeperCount = itemCount;
+		}
+
+		std::size_t selected = listLimit;
+		for (int level = 0; level < maxLength && selected > 0; level++)
+		{
+			std::size_t leaves = 0;
+			for (std::size_t item = 0; item < selected; item++) leaves += isLeaf[level][item];
+			for (std::size_t leaf = 0; leaf < leaves; leaf++) codeLengths[symbols[leaf]]++;
+
+			selected = 2 * (selected - leaves);
+		}
+	}
 
-	bool Comparator::operator() (HuffmanNode* left, HuffmanNode* right)
+	void LimitedCodeLengths(const std::uint64_t* counts, std::size_t alphabetSize, int maxLength, std::uint8_t* codeLengths)
 	{
-		return left->weight > right->weight;
+		HuffmanCodeLengths(counts, alphabetSize, codeLengths);
+		if (*std::max_element(codeLengths, codeLengths + alphabetSize) > maxLength)
+		{
+			PackageMergeCodeLengths(counts, alphabetSize, maxLength, codeLengths);
+		}
 	}
 
-	void CreateHeader(std::vector<std::bitset<8>>& encodedBits, const std::unordered_map<char, String>& huffmanCodes, int& bitIndex, std::size_t& byteIndex)
+	void AssignCanonicalCodes(const std::uint8_t* codeLengths, std::size_t alphabetSize, std::uint32_t* codes)
 	{
-		int numberOfCoddes  = huffmanCodes.size();
-		if (numberOfCoddes > 65536) throw Core::CompressionException("Too many symbols to encode");
+		std::uint32_t lengthCount[kMaxCodeLength + 1] = {};
+		for (std::size_t symbol = 0; symbol < alphabetSize; symbol++)
+		{
+			if (codeLengths[symbol] > kMaxCodeLength) throw Core::CompressionException("Unsupported code length");
+			lengthCount[codeLengths[symbol]]++;
+		}
+		lengthCount[0] = 0;
 
-		encodedBits.push_back(std::bitset<8>(0));
+		std::uint32_t nextCode[kMaxCodeLength + 1] = {};
+		std::uint32_t code = 0;
+		for (int length = 1; length <= kMaxCodeLength; length++)
+		{
+			code = (code + lengthCount[length - 1]) << 1;
+			nextCode[length] = code;
+		}
+
+		for (std::size_t symbol = 0; symbol < alphabetSize; symbol++)
+		{
+			int length = codeLengths[symbol];
+			codes[symbol] = 0;
+			if (length == 0) continue;
+
+			std::uint32_t value = nextCode[length]++;
+			std::uint32_t reversed = 0;
+			for (int i = 0; i < length; i++)
+			{
+				reversed = (reversed << 1) | ((value >> i) & 1);
+			}
+			codes[symbol] = reversed;
+		}
+	}
 
-		encodedBits.push_back(std::bitset<8>(numberOfCoddes & 0xFF));
-		encodedBits.push_back(std::bitset<8>((numberOfCoddes >> 8) & 0xFF));
+	std::size_t WriteCodeLengths(char* output, const std::uint8_t* codeLengths, std::size_t alphabetSize)
+	{
+		std::size_t size = 0;
 
-		bitIndex = 0;
-		byteIndex = 3;
-		encodedBits.push_back(std::bitset<8>());
-		for (auto& pair : huffmanCodes)
+		std::size_t symbol = 0;
+		while (symbol < alphabetSize)
 		{
+			std::uint8_t length = codeLengths[symbol];
+			std::size_t run = 1;
+			while (symbol + run < alphabetSize && codeLengths[symbol + run] == length) run++;
 
-			for (int i = 0; i < 8; i++)
+			if (length == 0)
+			{
+				if (run > 64)
+				{
+					run = std::min<std::size_t>(run, 256) & ~std::size_t(3);
+					output[size++] = static_cast<char>(0xC0 | (run / 4 - 1));
+				}
+				else
+				{
+					output[size++] = static_cast<char>(0x40 | (run - 1));
+				}
+				symbol += run;
+			}
+			else
 			{
-				if (bitIndex == 8)
+				output[size++] = static_cast<char>(length);
+				symbol++;
+				run = std::min<std::size_t>(run, 64);
+				if (--run > 0)
 				{
-					bitIndex = 0;
-					++byteIndex;
-					encodedBits.push_back(std::bitset<8>());
+					output[size++] = static_cast<char>(0x80 | (run - 1));
+					symbol += run;
 				}
+			}
+		}
 
-				bool bit = (pair.first >> i) & 1;
-				encodedBits[byteIndex][bitIndex] = bit;
+		return size;
+	}
+
+	std::size_t ReadCodeLengths(const char* data, std::size_t size, std::size_t offset, std::uint8_t* codeLengths, std::size_t alphabetSize)
+	{
+		std::size_t symbol = 0;
+		while (symbol < alphabetSize)
+		{
+			if (offset >= size) throw Core::CompressionException("Invalid data format");
+
+			std::uint8_t token = static_cast<std::uint8_t>(data[offset++]);
+			std::size_t run = (token & 0x3F) + 1;
+			switch (token >> 6)
+			{
+				case 0:
+					if (token > kMaxCodeLength) throw Core::CompressionException("Unsupported code length");
+					codeLengths[symbol++] = token;
+					break;
 
-				++bitIndex;
+				case 1:
+					if (symbol + run > alphabetSize) throw Core::CompressionException("Invalid data format");
+					std::fill_n(codeLengths + symbol, run, 0);
+					symbol += run;
+					break;
+
+				case 2:
+					if (symbol == 0 || symbol + run > alphabetSize) throw Core::CompressionException("Invalid data format");
+					std::fill_n(codeLengths + symbol, run, codeLengths[symbol - 1]);
+					symbol += run;
+					break;
+
+				default:
+					run *= 4;
+					if (symbol + run > alphabetSize) throw Core::CompressionException("Invalid data format");
+					std::fill_n(codeLengths + symbol, run, 0);
+					symbol += run;
+					break;
 			}
+		}
+
+		return offset;
+	}
 
-			int codeLength = pair.second.length();
-			char byteLegth = static_cast<char>(codeLength);
+	std::size_t CreateHeader(char* header, std::uint8_t blockType, const std::uint8_t* codeLengths, std::uint64_t symbolCount, std::uint32_t tableId)
+	{
+		std::size_t size = Core::WriteVarint(header, symbolCount);
+		header[size++] = static_cast<char>(blockType);
+		if (blockType == kSharedTableBlock)
+		{
+			for (int byte = 0; byte < 4; byte++) header[size++] = static_cast<char>(tableId >> (8 * byte));
+			return size;
+		}
+		if (blockType != kHuffmanBlock) return size;
+
+		return size + WriteCodeLengths(header + size, codeLengths, kAlphabetSize);
+	}
+
+	std::size_t ReadHeader(const char* block, std::size_t blockSize, std::uint8_t flags, std::uint8_t* codeLengths, std::uint64_t& symbolCount, std::uint8_t& blockType,
+		const SharedTable* sharedTable)
+	{
+		std::size_t offset = 0;
+		symbolCount = Core::ReadVarint(block, blockSize, offset);
+
+		blockType = kHuffmanBlock;
+		if (flags & kBlockTypesFlag)
+		{
+			if (offset >= blockSize) throw Core::CompressionException("Invalid data format");
+			blockType = static_cast<std::uint8_t>(block[offset++]);
+		}
+
+		switch (blockType)
+		{
+			case kStoredBlock:
+			case kRleBlock:
+				return offset;
 
-			for (int i = 0; i < 8; i++)
+			case kHuffmanBlock:
+				return ReadCodeLengths(block, blockSize, offset, codeLengths, kAlphabetSize);
+
+			case kSharedTableBlock:
 			{
-				if (bitIndex == 8)
-				{
-					bitIndex = 0;
-					++byteIndex;
-					encodedBits.push_back(std::bitset<8>());
-				}
+				if (!(flags & kSharedTableFlag) || blockSize - offset < 4) throw Core::CompressionException("Invalid data format");
 
-				bool bit = (byteLegth >> i) & 1;
-				encodedBits[byteIndex][bitIndex] = bit;
+				const std::uint8_t* id = reinterpret_cast<const std::uint8_t*>(block + offset);
+				std::uint32_t tableId = id[0] | (id[1] << 8) | (id[2] << 16) | (std::uint32_t(id[3]) << 24);
+				if (!sharedTable) throw Core::CompressionException("Data was encoded with a shared Huffman table, none was given");
+				if (sharedTable->id() != tableId) throw Core::CompressionException("Data was encoded with another shared Huffman table");
 
-				++bitIndex;
+				std::copy_n(sharedTable->codeLengths(), kAlphabetSize, codeLengths);
+				return offset + 4;
 			}
 
-			for (int i = 0; i < codeLength; i++)
+			default:
+				throw Core::CompressionException("Unsupported block type");
+		}
+	}
+
+	void DecodeTable::build(const std::vector<CodeEntry>& codes)
+	{
+		constexpr std::size_t rootSize = std::size_t(1) << kLookupBits;
+
+		entries.assign(rootSize, 0);
+		longestCode = 0;
+		shortestCode = 0;
+
+		int subTableLength[rootSize] = {};
+		for (const CodeEntry& code : codes)
+		{
+			if (code.length == 0) continue;
+			if (code.length > kMaxCodeLength) throw Core::CompressionException("Unsupported code length");
+
+			longestCode = std::max<int>(longestCode, code.length);
+			shortestCode = shortestCode == 0 ? code.length : std::min<int>(shortestCode, code.length);
+
+			if (code.length <= kLookupBits)
 			{
-				if (bitIndex == 8)
+				std::uint32_t entry = kValidFlag | code.length | (static_cast<std::uint32_t>(code.symbol) << 8);
+				for (std::size_t index = code.bits; index < rootSize; index += std::size_t(1) << code.length)
 				{
-					bitIndex = 0;
-					++byteIndex;
-					encodedBits.push_back(std::bitset<8>());
+					if (entries[index] != 0) throw Core::CompressionException("Invalid Huffman code set");
+					entries[index] = entry;
 				}
+			}
+			else
+			{
+				std::size_t prefix = code.bits & (rootSize - 1);
+				subTableLength[prefix] = std::max<int>(subTableLength[prefix], code.length);
+			}
+		}
+
+		for (std::size_t prefix = 0; prefix < rootSize; prefix++)
+		{
+			if (subTableLength[prefix] == 0) continue;
+			if (entries[prefix] != 0) throw Core::CompressionException("Invalid Huffman code set");
+
+			std::uint32_t subBits = subTableLength[prefix] - kLookupBits;
+			entries[prefix] = kSubTableFlag | subBits | (static_cast<std::uint32_t>(entries.size()) << 8);
+			entries.resize(entries.size() + (std::size_t(1) << subBits), 0);
+		}
+
+		for (const CodeEntry& code : codes)
+		{
+			if (code.length <= kLookupBits) continue;
 
-				bool bit = pair.second[i] == '1';
-				encodedBits[byteIndex][bitIndex] = bit;
+			std::uint32_t link = entries[code.bits & (rootSize - 1)];
+			std::size_t offset = link >> 8;
+			std::size_t subSize = std::size_t(1) << (link & kLengthMask);
+			std::uint32_t entry = kValidFlag | code.length | (static_cast<std::uint32_t>(code.symbol) << 8);
 
-				++bitIndex;
+			for (std::size_t index = code.bits >> kLookupBits; index < subSize; index += std::size_t(1) << (code.length - kLookupBits))
+			{
+				if (entries[offset + index] != 0) throw Core::CompressionException("Invalid Huffman code set");
+				entries[offset + index] = entry;
 			}
 		}
 	}
 
-	int ReadHeader(const std::vector<std::bitset<8>>& encodedBits, std::unordered_map<String, char>& huffmanCodes, int& bitIndex, std::size_t& byteIndex)
+	void DecodeTable::build(const std::uint8_t* codeLengths, std::size_t alphabetSize)
 	{
-		if (encodedBits.size() < 3)
+		canonicalCodes.resize(alphabetSize);
+		AssignCanonicalCodes(codeLengths, alphabetSize, canonicalCodes.data());
+
+		canonicalEntries.clear();
+		for (std::size_t symbol = 0; symbol < alphabetSize; symbol++)
 		{
-			throw Core::CompressionException("Invalid data format");
+			if (codeLengths[symbol] == 0) continue;
+			canonicalEntries.push_back({ canonicalCodes[symbol], codeLengths[symbol], static_cast<std::uint16_t>(symbol) });
+		}
+
+		build(canonicalEntries);
+	}
+
+	SharedTable::SharedTable(const std::uint8_t* codeLengths)
+	{
+		if (std::any_of(codeLengths, codeLengths + kAlphabetSize, [](std::uint8_t length) { return length == 0 || length > kMaxCodeLengthLimit; }))
+		{
+			throw Core::CompressionException("Invalid shared Huffman table");
+		}
+
+		std::copy_n(codeLengths, kAlphabetSize, lengths);
+		tableId = Core::Crc32({ reinterpret_cast<const char*>(lengths), kAlphabetSize });
+
+		std::uint32_t codes[kAlphabetSize];
+		AssignCanonicalCodes(lengths, kAlphabetSize, codes);
+		for (std::size_t symbol = 0; symbol < kAlphabetSize; symbol++) encodeTable[symbol] = { codes[symbol], lengths[symbol] };
+
+		table.build(lengths, kAlphabetSize);
+	}
+
+	SharedTable TrainSharedTable(const std::uint64_t* counts, int maxCodeLength)
+	{
+		std::uint64_t smoothedCounts[kAlphabetSize];
+		for (std::size_t symbol = 0; symbol < kAlphabetSize; symbol++) smoothedCounts[symbol] = counts[symbol] + 1;
+
+		std::uint8_t codeLengths[kAlphabetSize];
+		LimitedCodeLengths(smoothedCounts, kAlphabetSize, std::clamp(maxCodeLength, kMinCodeLengthLimit, kMaxCodeLengthLimit), codeLengths);
+		return SharedTable(codeLengths);
+	}
+
+	void WriteSharedTable(const SharedTable& table, std::vector<char>& output)
+	{
+		output.insert(output.end(), kSharedTableMagic, kSharedTableMagic + sizeof(kSharedTableMagic));
+		for (int byte = 0; byte < 4; byte++) output.push_back(static_cast<char>(table.id() >> (8 * byte)));
+
+		std::size_t offset = output.size();
+		output.resize(offset + kAlphabetSize);
+		output.resize(offset + WriteCodeLengths(output.data() + offset, table.codeLengths(), kAlphabetSize));
+	}
+
+	SharedTable ReadSharedTable(std::span<const char> data)
+	{
+		if (data.size() < sizeof(kSharedTableMagic) + 4 || !std::equal(kSharedTableMagic, kSharedTableMagic + sizeof(kSharedTableMagic), data.data()))
+		{
+			throw Core::CompressionException("Not a shared Huffman table");
 		}
 
-		int bitsToTrim = static_cast<int>(encodedBits[0].to_ulong());
+		const std::uint8_t* id = reinterpret_cast<const std::uint8_t*>(data.data() + sizeof(kSharedTableMagic));
+		std::uint32_t tableId = id[0] | (id[1] << 8) | (id[2] << 16) | (std::uint32_t(id[3]) << 24);
 
-		int numberOfCoddes = (encodedBits[1].to_ulong()) | (encodedBits[2].to_ulong() << 8);
+		std::uint8_t codeLengths[kAlphabetSize];
+		std::size_t end = ReadCodeLengths(data.data(), data.size(), sizeof(kSharedTableMagic) + 4, codeLengths, kAlphabetSize);
+		if (end != data.size()) throw Core::CompressionException("Invalid shared Huffman table");
 
-		byteIndex = 3;
-		bitIndex = 0;
+		SharedTable table(codeLengths);
+		if (table.id() != tableId) throw Core::CompressionException("Shared Huffman table checksum mismatch");
+		return table;
+	}
+
+	int ReadLegacyHeader(std::span<const char> encodedBytes, std::vector<CodeEntry>& codes, std::size_t& headerBits)
+	{
+		if (encodedBytes.size() < 3)
+		{
+			throw Core::CompressionException("Invalid data format");
+		}
+
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(encodedBytes.data());
+		int bitsToTrim = bytes[0];
+		int numberOfCoddes = bytes[1] | (bytes[2] << 8);
+
+		Core::BitReader reader(bytes + 3, encodedBytes.size() - 3);
+		codes.clear();
+		codes.reserve(numberOfCoddes);
 
 		for (int i = 0; i < numberOfCoddes; ++i)
 		{
-			char character = 0;
-			for (int j = 0; j < 8; ++j)
+			CodeEntry code;
+			code.symbol = static_cast<std::uint8_t>(reader.readBits(8));
+			code.length = static_cast<std::uint8_t>(reader.readBits(8));
+			if (code.length > kMaxCodeLength) throw Core::CompressionException("Unsupported code length");
+			code.bits = static_cast<std::uint32_t>(reader.readBits(code.length));
+
+			codes.push_back(code);
+		}
+
+		if (reader.overflowed()) throw Core::CompressionException("Invalid data format");
+
+		headerBits = 24 + reader.position();
+		return bitsToTrim;
+	}
+
+	void EncodeBlock(const char* data, std::size_t dataSize, std::vector<char>& encodedBlock, int maxCodeLength, bool interleaved,
+		std::shared_ptr<const SharedTable> sharedTable)
+	{
+		HuffmanEncoder encoder(dataSize, 1, maxCodeLength, interleaved, std::move(sharedTable));
+
+		std::size_t offset = encodedBlock.size();
+		encodedBlock.resize(offset + BlockBound(dataSize) + 8);
+		encodedBlock.resize(offset + encoder.encodeBlock(data, dataSize, encodedBlock.data() + offset, encodedBlock.size() - offset));
+	}
+
+	void DecodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize, std::uint8_t flags,
+		std::shared_ptr<const SharedTable> sharedTable)
+	{
+		HuffmanDecoder decoder(1, std::move(sharedTable));
+		decoder.decodeBlock(block, blockSize, output, outputSize, flags);
+	}
+
+	static void CheckFlags(std::uint8_t flags)
+	{
+		if (flags & ~kSupportedFlags) throw Core::CompressionException("Unsupported format flags");
+	}
+
+	static std::uint8_t StreamFlags(bool interleaved, bool sharedTable)
+	{
+		return static_cast<std::uint8_t>(kBlockTypesFlag | (interleaved ? kInterleavedFlag : 0) | (sharedTable ? kSharedTableFlag : 0));
+	}
+
+	static Core::BlockDecoder FlaggedBlockDecoder(std::uint8_t flags, const std::shared_ptr<const SharedTable>& sharedTable)
+	{
+		return [flags, sharedTable](const char* block, std::size_t blockSize, char* output, std::size_t outputSize)
+		{
+			DecodeBlock(block, blockSize, output, outputSize, flags, sharedTable);
+		};
+	}
+
+	static std::size_t PackSymbols(const std::uint8_t* input, std::size_t size, const EncodeEntry* table, int maxLength, std::uint8_t* output)
+	{
+		Core::BitWriter writer(output);
+
+		const std::size_t symbolsPerFlush = 56 / maxLength;
+		std::size_t i = 0;
+		while (i + symbolsPerFlush <= size)
+		{
+			for (std::size_t k = 0; k < symbolsPerFlush; k++)
 			{
-				if (bitIndex == 8)
-				{
-					bitIndex = 0;
-					++byteIndex;
-				}
-				character |= (encodedBits[byteIndex][bitIndex] << j);
-				++bitIndex;
+				const EncodeEntry& code = table[input[i++]];
+				writer.write(code.bits, code.length);
 			}
+			writer.flush();
+		}
+		while (i < size)
+		{
+			const EncodeEntry& code = table[input[i++]];
+			writer.write(code.bits, code.length);
+			writer.flush();
+		}
+
+		return writer.finish();
+	}
 
-			int codeLength = 0;
-			for (int j = 0; j < 8; ++j)
+	static void DecodeSymbols(const DecodeTable& table, Core::BitReader& reader, char* output, std::size_t size)
+	{
+		const std::size_t symbolsPerRefill = 56 / table.maxLength();
+		std::size_t i = 0;
+		while (i + symbolsPerRefill <= size)
+		{
+			reader.refill();
+			for (std::size_t k = 0; k < symbolsPerRefill; k++)
 			{
-				if (bitIndex == 8)
-				{
-					bitIndex = 0;
-					++byteIndex;
-				}
-				codeLength |= (encodedBits[byteIndex][bitIndex] << j);
-				++bitIndex;
+				output[i++] = static_cast<char>(table.decodeSymbol(reader));
+			}
+		}
+		while (i < size)
+		{
+			reader.refill();
+			output[i++] = static_cast<char>(table.decodeSymbol(reader));
+		}
+	}
+
+	HuffmanEncoder::HuffmanEncoder(std::size_t blockSize, unsigned threadCount, int maxCodeLength, bool interleaved, std::shared_ptr<const SharedTable> sharedTable)
+		: blockSize(std::max<std::size_t>(blockSize, 1)), threadCount(std::max(threadCount, 1u)),
+		maxCodeLength(std::clamp(maxCodeLength, kMinCodeLengthLimit, kMaxCodeLengthLimit)), interleaved(interleaved), sharedTable(std::move(sharedTable)) {}
+
+	std::size_t HuffmanEncoder::encode(std::span<const std::byte> data, std::span<std::byte> encodedData)
+	{
+		const char* input = reinterpret_cast<const char*>(data.data());
+		char* output = reinterpret_cast<char*>(encodedData.data());
+
+		if (data.size() <= blockSize)
+		{
+			if (encodedData.size() < 2) throw Core::CompressionException("Output buffer too small");
+
+			output[0] = static_cast<char>(kFormatMarker | kFormatVersion);
+			output[1] = static_cast<char>(StreamFlags(interleaved, sharedTable != nullptr));
+
+			Core::BlockTimer timer(data.size());
+			std::size_t size = 2 + encodeBlock(input, data.size(), output + 2, encodedData.size() - 2);
+			timer.stop(size);
+			return size;
+		}
+
+		auto encodeBlock = [this](const char* block, std::size_t size, std::vector<char>& encodedBlock)
+		{
+			EncodeBlock(block, size, encodedBlock, maxCodeLength, interleaved, sharedTable);
+		};
+
+		std::vector<char> container;
+		Core::EncodeBlocks(kFormatMarker | kContainerVersion, StreamFlags(interleaved, sharedTable != nullptr), input, data.size(), blockSize, threadCount, encodeBlock, container);
+		if (container.size() > encodedData.size()) throw Core::CompressionException("Output buffer too small");
+
+		std::copy(container.begin(), container.end(), output);
+		return container.size();
+	}
+
+	std::size_t HuffmanEncoder::encodeBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity)
+	{
+		if (sharedTable && dataSize <= kSharedTableBlockLimit) return encodeSharedBlock(data, dataSize, encodedBlock, capacity);
+
+		const std::uint8_t* input = reinterpret_cast<const std::uint8_t*>(data);
+
+		char header[kMaxHeaderSize];
+		auto storeBlock = [&](std::uint8_t blockType, std::size_t payloadSize)
+		{
+			std::size_t headerSize = CreateHeader(header, blockType, codeLengths, dataSize);
+			if (headerSize + payloadSize > capacity) throw Core::CompressionException("Output buffer too small");
+
+			Core::AddCounter(Core::Counter::HeaderBytes, headerSize);
+			if (blockType == kStoredBlock) Core::AddCounter(Core::Counter::StoredBlocks, 1);
+
+			std::copy_n(header, headerSize, encodedBlock);
+			std::copy_n(data, payloadSize, encodedBlock + headerSize);
+			return headerSize + payloadSize;
+		};
+
+		{
+			Core::ScopedTimer timer(Core::Phase::Histogram);
+
+			// Already compressed data is recognized from a sample, before paying for a full histogram.
+			if (dataSize > Core::kSampleChunkCount * Core::kSampleChunkSize)
+			{
+				Core::CountSample(input, dataSize, counts);
+				if (Core::Entropy(counts) >= kStoredBlockEntropy) return storeBlock(kStoredBlock, dataSize);
+			}
+
+			Core::CountBytes(input, dataSize, counts, threadCount);
+		}
+
+		std::size_t usedCount = std::count_if(counts, counts + kAlphabetSize, [](std::uint64_t count) { return count > 0; });
+		if (usedCount == 0) return storeBlock(kStoredBlock, 0);
+		if (usedCount == 1) return storeBlock(kRleBlock, 1);
+
+		std::uint64_t payloadBits = 0;
+		int maxLength = 1;
+		{
+			Core::ScopedTimer timer(Core::Phase::CodeLengths);
+			LimitedCodeLengths(counts, kAlphabetSize, maxCodeLength, codeLengths);
+
+			std::uint32_t codes[kAlphabetSize];
+			AssignCanonicalCodes(codeLengths, kAlphabetSize, codes);
+
+			for (std::size_t symbol = 0; symbol < kAlphabetSize; symbol++)
+			{
+				table[symbol] = { codes[symbol], codeLengths[symbol] };
+				maxLength = std::max<int>(maxLength, codeLengths[symbol]);
+				payloadBits += counts[symbol] * codeLengths[symbol];
 			}
+		}
+
+		std::size_t storedSize;
+		std::size_t headerSize;
+		{
+			Core::ScopedTimer timer(Core::Phase::Header);
+			storedSize = CreateHeader(header, kStoredBlock, codeLengths, dataSize) + dataSize;
+			headerSize = CreateHeader(header, kHuffmanBlock, codeLengths, dataSize);
+		}
+
+		// Every interleaved stream pads its last byte.
+		std::size_t encodedSize = headerSize + (payloadBits + 7) / 8;
+		if (interleaved) encodedSize += kJumpTableSize + kInterleavedStreams - 1;
+
+		if (encodedSize >= storedSize) return storeBlock(kStoredBlock, dataSize);
+		if (encodedSize > capacity) throw Core::CompressionException("Output buffer too small");
 
-			String code;
-			for (int j = 0; j < codeLength; ++j)
+		char* payload = encodedBlock + headerSize;
+		if (capacity - encodedSize < 8)
+		{
+			scratch.resize(encodedSize - headerSize + 8);
+			payload = scratch.data();
+		}
+
+		Core::ScopedTimer timer(Core::Phase::Packing);
+		Core::AddCounter(Core::Counter::Symbols, dataSize);
+		Core::AddCounter(Core::Counter::CodedBits, payloadBits);
+		Core::AddCounter(Core::Counter::HeaderBytes, headerSize);
+		Core::MaxCounter(Core::Counter::MaxCodeLength, maxLength);
+
+		std::uint8_t* bytes = reinterpret_cast<std::uint8_t*>(payload);
+		std::size_t payloadSize = 0;
+		if (!interleaved)
+		{
+			payloadSize = PackSymbols(input, dataSize, table, maxLength, bytes);
+		}
+		else
+		{
+			std::size_t segmentSize = (dataSize + kInterleavedStreams - 1) / kInterleavedStreams;
+			payloadSize = kJumpTableSize;
+			for (std::size_t stream = 0; stream < kInterleavedStreams; stream++)
 			{
-				if (bitIndex == 8)
+				std::size_t begin = std::min(stream * segmentSize, dataSize);
+				std::size_t streamSize = PackSymbols(input + begin, std::min(segmentSize, dataSize - begin), table, maxLength, bytes + payloadSize);
+				if (stream + 1 < kInterleavedStreams)
 				{
-					bitIndex = 0;
-					++byteIndex;
+					for (int byte = 0; byte < 4; byte++) bytes[4 * stream + byte] = static_cast<std::uint8_t>(streamSize >> (8 * byte));
 				}
-				code += (encodedBits[byteIndex][bitIndex] ? '1' : '0');
-				++bitIndex;
+				payloadSize += streamSize;
 			}
-
-			huffmanCodes[code] = character;
 		}
 
-		return bitsToTrim;
+		if (payload != encodedBlock + headerSize) std::copy_n(payload, payloadSize, encodedBlock + headerSize);
+		std::copy_n(header, headerSize, encodedBlock);
+
+		return headerSize + payloadSize;
 	}
 
-	void HuffmanCompression::encode(const std::shared_ptr<char>& data, std::size_t dataSize, std::vector<std::bitset<8>>& encodedData) const
+	std::size_t HuffmanEncoder::encodeSharedBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity)
 	{
-		std::unordered_map<char, int> wieghts;
-		std::unordered_map<char, String> huffmanCodes;
-		std::priority_queue<HuffmanNode*, std::vector<HuffmanNode*>, Comparator> pq;
+		char header[kMaxHeaderSize];
+		std::size_t headerSize = CreateHeader(header, kSharedTableBlock, nullptr, dataSize, sharedTable->id());
+		std::size_t storedHeaderSize = CreateHeader(header + headerSize, kStoredBlock, nullptr, dataSize);
+
+		// The coded size is only known after packing, the scratch buffer has room for the longest codes.
+		int maxLength = sharedTable->decodeTable().maxLength();
+		scratch.resize(dataSize * maxLength / 8 + 16);
+		std::size_t payloadSize;
+		{
+			Core::ScopedTimer timer(Core::Phase::Packing);
+			payloadSize = PackSymbols(reinterpret_cast<const std::uint8_t*>(data), dataSize, sharedTable->codes(), maxLength, reinterpret_cast<std::uint8_t*>(scratch.data()));
+		}
+
+		const char* payload = scratch.data();
+		if (headerSize + payloadSize >= storedHeaderSize + dataSize)
+		{
+			std::copy_n(header + headerSize, storedHeaderSize, header);
+			headerSize = storedHeaderSize;
+			payload = data;
+			payloadSize = dataSize;
+			Core::AddCounter(Core::Counter::StoredBlocks, 1);
+		}
+		else
+		{
+			Core::AddCounter(Core::Counter::Symbols, dataSize);
+			Core::AddCounter(Core::Counter::CodedBits, payloadSize * 8);
+			Core::MaxCounter(Core::Counter::MaxCodeLength, maxLength);
+		}
+		if (headerSize + payloadSize > capacity) throw Core::CompressionException("Output buffer too small");
+
+		Core::AddCounter(Core::Counter::HeaderBytes, headerSize);
+		std::copy_n(header, headerSize, encodedBlock);
+		std::copy_n(payload, payloadSize, encodedBlock + headerSize);
+		return headerSize + payloadSize;
+	}
 
-		for (std::size_t i = 0; i < dataSize; i++)
+	HuffmanDecoder::HuffmanDecoder(unsigned threadCount, std::shared_ptr<const SharedTable> sharedTable)
+		: threadCount(std::max(threadCount, 1u)), sharedTable(std::move(sharedTable)) {}
+
+	std::size_t HuffmanDecoder::decodedSize(std::span<const std::byte> encodedData)
+	{
+		std::span<const char> input(reinterpret_cast<const char*>(encodedData.data()), encodedData.size());
+		if (input.empty() || !(static_cast<std::uint8_t>(input[0]) & kFormatMarker))
 		{
-			char temp = data.get()[i];
+			if (input.data() != legacyInput.data() || input.size() != legacyInput.size()) decodeLegacy(input);
+			return legacyOutput.size();
+		}
 
-			if (wieghts.contains(temp))
+		switch (static_cast<std::uint8_t>(input[0]))
+		{
+			case kFormatMarker | kFormatVersion:
 			{
-				wieghts[temp] += 1;
+				if (input.size() < 3) throw Core::CompressionException("Invalid data format");
+				CheckFlags(static_cast<std::uint8_t>(input[1]));
+
+				std::size_t offset = 2;
+				std::size_t symbolCount = Core::ReadVarint(input.data(), input.size(), offset);
+
+				// Only a run block holds more symbols than bits.
+				bool runBlock = (input[1] & kBlockTypesFlag) && offset < input.size() && input[offset] == kRleBlock;
+				if (symbolCount > (runBlock ? Core::kMaxBlockSize : (input.size() - 2) * 8)) throw Core::CompressionException("Invalid data format");
+
+				return symbolCount;
 			}
-			else
+
+			case kFormatMarker | kContainerVersion:
 			{
-				wieghts[temp] = 1;
+				Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+				CheckFlags(index.flags);
+
+				return index.originalSize;
 			}
+
+			default:
+				throw Core::CompressionException("Unsupported format version");
 		}
+	}
+
+	std::size_t HuffmanDecoder::decode(std::span<const std::byte> encodedData, std::span<std::byte> data)
+	{
+		std::size_t size = decodedSize(encodedData);
+		if (size > data.size()) throw Core::CompressionException("Output buffer too small");
 
-		for (auto& pair : wieghts)
+		std::span<const char> input(reinterpret_cast<const char*>(encodedData.data()), encodedData.size());
+		char* output = reinterpret_cast<char*>(data.data());
+
+		if (input.empty() || !(static_cast<std::uint8_t>(input[0]) & kFormatMarker))
+		{
+			std::copy(legacyOutput.begin(), legacyOutput.end(), output);
+			legacyInput = {};
+		}
+		else if (static_cast<std::uint8_t>(input[0]) == (kFormatMarker | kFormatVersion))
 		{
-			HuffmanNode* n = new HuffmanNode(pair.first, pair.second);
-			pq.push(n);
+			Core::BlockTimer timer(input.size());
+			decodeBlock(input.data() + 2, input.size() - 2, output, size, static_cast<std::uint8_t>(input[1]));
+			timer.stop(size);
 		}
+		else
+		{
+			Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+			Core::DecodeBlocks(input.data(), index, 0, index.originalSize, output, threadCount, FlaggedBlockDecoder(index.flags, sharedTable));
+		}
+
+		return size;
+	}
 
-		while (pq.size() > 1)
+	void HuffmanDecoder::decodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize, std::uint8_t flags)
+	{
+		std::uint8_t codeLengths[kAlphabetSize];
+		std::uint64_t symbolCount;
+		std::uint8_t blockType;
+		std::size_t headerSize;
 		{
-			HuffmanNode* n1 = pq.top();
-			pq.pop();
+			Core::ScopedTimer timer(Core::Phase::Header);
+			headerSize = ReadHeader(block, blockSize, flags, codeLengths, symbolCount, blockType, sharedTable.get());
+		}
+		if (symbolCount != outputSize) throw Core::CompressionException("Block size does not match the block index");
 
+		if (blockType == kStoredBlock)
+		{
+			if (blockSize - headerSize != outputSize) throw Core::CompressionException("Invalid data format");
+			std::copy_n(block + headerSize, outputSize, output);
+			return;
+		}
+		if (blockType == kRleBlock)
+		{
+			if (blockSize - headerSize != 1) throw Core::CompressionException("Invalid data format");
+			std::fill_n(output, outputSize, block[headerSize]);
+			return;
+		}
+
+
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(block);
+		if (blockType == kSharedTableBlock)
+		{
+			const DecodeTable& sharedCodes = sharedTable->decodeTable();
+			if (symbolCount > (blockSize - headerSize) * 8 / sharedCodes.minLength()) throw Core::CompressionException("Invalid data format");
+
+			Core::ScopedTimer timer(Core::Phase::Unpacking);
+			Core::BitReader reader(bytes + headerSize, blockSize - headerSize);
+			DecodeSymbols(sharedCodes, reader, output, outputSize);
+			if (reader.overflowed()) throw Core::CompressionException("Invalid data format");
+			return;
+		}
+
+		{
+			Core::ScopedTimer timer(Core::Phase::CodeLengths);
+			table.build(codeLengths, kAlphabetSize);
+		}
+		if (symbolCount == 0) return;
+		if (table.empty()) throw Core::CompressionException("Invalid data format");
 
-			HuffmanNode* n2 = pq.top();
-			pq.pop();
-			pq.push(new HuffmanNode(n1, n2));
+		if (symbolCount > (blockSize - headerSize) * 8 / table.minLength())
+		{
+			throw Core::CompressionException("Invalid data format");
 		}
 
-		HuffmanNode::getLeaves(pq.top(), huffmanCodes, "");
+		Core::ScopedTimer timer(Core::Phase::Unpacking);
+		if (!(flags & kInterleavedFlag))
+		{
+			Core::BitReader reader(bytes + headerSize, blockSize - headerSize);
+			DecodeSymbols(table, reader, output, outputSize);
+			if (reader.overflowed()) throw Core::CompressionException("Invalid data format");
+			return;
+		}
 
-		int bitIndex = 0;
-		std::size_t byteIndex;
-		CreateHeader(encodedData, huffmanCodes, bitIndex, byteIndex);
+		if (blockSize - headerSize < kJumpTableSize) throw Core::CompressionException("Invalid data format");
 
-		for (std::size_t i = 0; i < dataSize; i++)
+		std::size_t streamOffsets[kInterleavedStreams + 1];
+		streamOffsets[0] = headerSize + kJumpTableSize;
+		for (std::size_t stream = 0; stream + 1 < kInterleavedStreams; stream++)
 		{
-			String code = huffmanCodes[data.get()[i]];
+			const std::uint8_t* size = bytes + headerSize + 4 * stream;
+			std::size_t streamSize = size[0] | (size[1] << 8) | (size[2] << 16) | (std::size_t(size[3]) << 24);
+			if (streamSize > blockSize - streamOffsets[stream]) throw Core::CompressionException("Invalid data format");
+			streamOffsets[stream + 1] = streamOffsets[stream] + streamSize;
+		}
+		streamOffsets[kInterleavedStreams] = blockSize;
+
+		std::size_t segmentSize = (outputSize + kInterleavedStreams - 1) / kInterleavedStreams;
+		std::size_t lastSegmentSize = outputSize - std::min(outputSize, (kInterleavedStreams - 1) * segmentSize);
+
+		Core::BitReader first(bytes + streamOffsets[0], streamOffsets[1] - streamOffsets[0]);
+		Core::BitReader second(bytes + streamOffsets[1], streamOffsets[2] - streamOffsets[1]);
+		Core::BitReader third(bytes + streamOffsets[2], streamOffsets[3] - streamOffsets[2]);
+		Core::BitReader fourth(bytes + streamOffsets[3], streamOffsets[4] - streamOffsets[3]);
 
-			for (int j = 0; j < code.length(); j++)
+		char* firstOutput = output;
+		char* secondOutput = output + std::min(outputSize, segmentSize);
+		char* thirdOutput = output + std::min(outputSize, 2 * segmentSize);
+		char* fourthOutput = output + std::min(outputSize, 3 * segmentSize);
+
+		// The last segment is the shortest, all four streams advance together over its length.
+		const std::size_t symbolsPerRefill = 56 / table.maxLength();
+		std::size_t i = 0;
+		while (i + symbolsPerRefill <= lastSegmentSize)
+		{
+			first.refill();
+			second.refill();
+			third.refill();
+			fourth.refill();
+			for (std::size_t k = 0; k < symbolsPerRefill; k++, i++)
 			{
-				if (bitIndex == 8)
+				firstOutput[i] = static_cast<char>(table.decodeSymbol(first));
+				secondOutput[i] = static_cast<char>(table.decodeSymbol(second));
+				thirdOutput[i] = static_cast<char>(table.decodeSymbol(third));
+				fourthOutput[i] = static_cast<char>(table.decodeSymbol(fourth));
+			}
+		}
+
+		DecodeSymbols(table, first, firstOutput + i, secondOutput - firstOutput - i);
+		DecodeSymbols(table, second, secondOutput + i, thirdOutput - secondOutput - i);
+		DecodeSymbols(table, third, thirdOutput + i, fourthOutput - thirdOutput - i);
+		DecodeSymbols(table, fourth, fourthOutput + i, lastSegmentSize - i);
+
+		if (first.overflowed() || second.overflowed() || third.overflowed() || fourth.overflowed())
+		{
+			throw Core::CompressionException("Invalid data format");
+		}
+	}
+
+	void HuffmanDecoder::decodeLegacy(std::span<const char> dataToDecode)
+	{
+		legacyInput = {};
+		legacyOutput.clear();
+
+		std::size_t headerBits;
+		int bitsToTrim = ReadLegacyHeader(dataToDecode, codes, headerBits);
+
+		table.build(codes);
+
+		std::size_t endBit = (dataToDecode.size() - 1) * 8 + bitsToTrim;
+		if (!table.empty() && endBit > headerBits)
+		{
+			const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(dataToDecode.data());
+			std::size_t startByte = headerBits / 8;
+			Core::BitReader reader(bytes + startByte, dataToDecode.size() - startByte);
+			endBit -= startByte * 8;
+			reader.refill();
+			reader.consume(static_cast<int>(headerBits % 8));
+
+			std::size_t outputIndex = 0;
+			legacyOutput.resize((endBit - reader.position()) / table.minLength());
+			char* output = legacyOutput.data();
+
+			const int symbolsPerRefill = 56 / table.maxLength();
+			while (reader.position() + 56 <= endBit)
+			{
+				reader.refill();
+				for (int i = 0; i < symbolsPerRefill; i++)
 				{
-					bitIndex = 0;
-					++byteIndex;
-					encodedData.push_back(std::bitset<8>());
+					output[outputIndex++] = static_cast<char>(table.decodeSymbol(reader));
 				}
+			}
 
-				bool bit = code[j] == '1';
-				encodedData[byteIndex][bitIndex] = bit;
+			while (true)
+			{
+				reader.refill();
+				std::size_t position = reader.position();
+				if (position >= endBit) break;
+
+				std::uint32_t entry = table.lookup(reader);
+				if (!(entry & DecodeTable::kValidFlag)) throw Core::CompressionException("Invalid Huffman code");
+
+				int length = entry & DecodeTable::kLengthMask;
+				if (position + length > endBit) break;
 
-				++bitIndex;
+				reader.consume(length);
+				output[outputIndex++] = static_cast<char>(entry >> 8);
 			}
+
+			legacyOutput.resize(outputIndex);
 		}
 
-		int complement = bitIndex;
-		encodedData[0] = std::bitset<8>(complement);
+		legacyInput = dataToDecode;
 	}
 
-	void HuffmanCompression::decode(const std::vector<std::bitset<8>>& dataToDecode, std::vector<char>& data) const
+	HuffmanCompression::HuffmanCompression(std::size_t blockSize, unsigned threadCount, std::size_t memoryBudget, int maxCodeLength, bool interleaved,
+		std::shared_ptr<const SharedTable> sharedTable)
+		: blockSize(std::clamp<std::size_t>(blockSize, 1, Core::kMaxBlockSize)), threadCount(std::max(threadCount, 1u)), memoryBudget(memoryBudget),
+		maxCodeLength(std::clamp(maxCodeLength, kMinCodeLengthLimit, kMaxCodeLengthLimit)), interleaved(interleaved), sharedTable(std::move(sharedTable)) {}
+
+	std::size_t HuffmanCompression::compressBound(std::size_t dataSize) const
 	{
-		std::unordered_map<String, char> huffmanCodes;
-		int bitIndex;
-		std::size_t byteIndex;
-		int bitsToTrim = ReadHeader(dataToDecode, huffmanCodes, bitIndex, byteIndex);
+		if (dataSize <= blockSize) return 2 + BlockBound(dataSize) + 8;
 
+		return Core::ContainerBound(dataSize, blockSize, kMaxHeaderSize);
+	}
 
+	std::unique_ptr<Core::EncoderContext> HuffmanCompression::createEncoder() const
+	{
+		return std::make_unique<HuffmanEncoder>(blockSize, threadCount, maxCodeLength, interleaved, sharedTable);
+	}
+
+	std::unique_ptr<Core::DecoderContext> HuffmanCompression::createDecoder() const
+	{
+		return std::make_unique<HuffmanDecoder>(threadCount, sharedTable);
+	}
 
-		String code = "";
-		if (bitIndex == 8)
+	void HuffmanCompression::decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const
+	{
+		if (dataToDecode.empty() || static_cast<std::uint8_t>(dataToDecode[0]) != (kFormatMarker | kContainerVersion))
 		{
-			bitIndex = 0;
-			++byteIndex;
+			Core::CompressionMethod::decodeRange(dataToDecode, offset, length, data);
+			return;
 		}
 
-		std::size_t decodDataSize = dataToDecode.size();
-		while (byteIndex < decodDataSize)
-		{
-			code += dataToDecode[byteIndex][bitIndex] ? "1" : "0";
+		Core::BlockIndex index = Core::ReadBlockIndex(dataToDecode.data(), dataToDecode.size());
+		CheckFlags(index.flags);
+
+		offset = std::min(offset, index.originalSize);
+		length = std::min(length, index.originalSize - offset);
+
+		std::size_t outputOffset = data.size();
+		data.resize(outputOffset + length);
+		Core::DecodeBlocks(dataToDecode.data(), index, offset, length, data.data() + outputOffset, threadCount, FlaggedBlockDecoder(index.flags, sharedTable));
+	}
 
-			if (huffmanCodes.contains(code))
+	void HuffmanCompression::encodeStream(std::istream& input, std::ostream& output) const
+	{
+		Core::EncodeBlockStream(kFormatMarker | kContainerVersion, kFormatMarker | kFormatVersion, StreamFlags(interleaved, sharedTable != nullptr), input, output,
+			blockSize, threadCount, memoryBudget, [this](const char* block, std::size_t size, std::vector<char>& encodedBlock)
 			{
-				data.push_back(huffmanCodes[code]);
-				code = "";
-			}
+				EncodeBlock(block, size, encodedBlock, maxCodeLength, interleaved, sharedTable);
+			});
+	}
 
-			++bitIndex;
-			if (bitIndex == 8)
+	void HuffmanCompression::decodeStream(std::istream& input, std::ostream& output) const
+	{
+		int first = input.peek();
+		if (first != (kFormatMarker | kContainerVersion))
+		{
+			std::vector<char> dataToDecode;
+			char buffer[1 << 16];
+			while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0)
 			{
-				bitIndex = 0;
-				++byteIndex;
+				dataToDecode.insert(dataToDecode.end(), buffer, buffer + input.gcount());
 			}
 
-			if (byteIndex == decodDataSize - 1 and bitIndex >= bitsToTrim) break;
+			std::vector<char> data;
+			decode(dataToDecode, data);
+			output.write(data.data(), data.size());
+		}
+		else
+		{
+			input.get();
+			std::uint8_t flags = static_cast<std::uint8_t>(input.get());
+			CheckFlags(flags);
+
+			Core::DecodeBlockStream(input, output, threadCount, memoryBudget, kMaxHeaderSize, FlaggedBlockDecoder(flags, sharedTable));
+		}
+
+		if (!output) throw Core::CompressionException("Error writing output");
+	}
+
+	void HuffmanCompression::encodeStream(std::span<const char> input, std::ostream& output) const
+	{
+		Core::EncodeBlockStream(kFormatMarker | kContainerVersion, kFormatMarker | kFormatVersion, StreamFlags(interleaved, sharedTable != nullptr), input, output,
+			blockSize, threadCount, memoryBudget, [this](const char* block, std::size_t size, std::vector<char>& encodedBlock)
+			{
+				EncodeBlock(block, size, encodedBlock, maxCodeLength, interleaved, sharedTable);
+			});
+	}
+
+	void HuffmanCompression::decodeStream(std::span<const char> input, std::ostream& output) const
+	{
+		if (input.empty() || static_cast<std::uint8_t>(input[0]) != (kFormatMarker | kContainerVersion))
+		{
+			std::vector<char> data;
+			decode(input, data);
+			output.write(data.data(), data.size());
 		}
+		else
+		{
+			Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+			CheckFlags(index.flags);
+
+			Core::DecodeBlockStream(input.data(), index, output, threadCount, memoryBudget, FlaggedBlockDecoder(index.flags, sharedTable));
+		}
+
+		if (!output) throw Core::CompressionException("Error writing output");
 	}
 }
\ No newline at end of file
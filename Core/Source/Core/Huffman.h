@@ -1,102 +1,509 @@
 #pragma once
 
 #include"Core.h"
-#include <unordered_map> 
-#include <queue>
+#include "BitStream.h"
+#include "BlockContainer.h"
+#include "Histogram.h"
 
 
 
 namespace Huffman
 {
 	/**
-	* @brief Represents a node in a Huffman tree.
+	* @brief Number of symbols in the byte alphabet.
 	*/
-	class HuffmanNode {
-	public:
+	constexpr std::size_t kAlphabetSize = 256;
 
-		char character;
+	/**
+	* @brief Largest alphabet supported by the code construction, for methods coding more than bytes.
+	*/
+	constexpr std::size_t kMaxAlphabetSize = 512;
 
-		int weight;
-	private:
-		HuffmanNode* left;
+	/**
+	* @brief Longest code length accepted by the decoder.
+	*/
+	constexpr int kMaxCodeLength = 32;
+
+	/**
+	* @brief Number of bits resolved by the first level of the decode table.
+	*/
+	constexpr int kLookupBits = 11;
+
+	/**
+	* @brief Default limit on the length of the codes built by the encoder.
+	*
+	* Every code then resolves in the first level of the decode table, which fits in L1.
+	*/
+	constexpr int kDefaultCodeLengthLimit = kLookupBits;
+
+	/**
+	* @brief Smallest selectable code length limit, enough for a code over the whole byte alphabet.
+	*/
+	constexpr int kMinCodeLengthLimit = 8;
+
+	/**
+	* @brief Largest selectable code length limit.
+	*/
+	constexpr int kMaxCodeLengthLimit = 15;
+
+	/**
+	* @brief High bit of the first byte marking a versioned stream.
+	*
+	* Legacy streams start with the number of bits used in the last byte (0-8).
+	*/
+	constexpr std::uint8_t kFormatMarker = 0x80;
+
+	/**
+	* @brief Version of the canonical code stream format holding a single block.
+	*
+	* The stream format:
+	* - 8 bits: kFormatMarker | kFormatVersion
+	* - 8 bits: flags, see kBlockTypesFlag
+	* - A block written by EncodeBlock
+	*/
+	constexpr std::uint8_t kFormatVersion = 2;
+
+	/**
+	* @brief Version of the block container format, see Core::EncodeBlocks.
+	*
+	* Inputs larger than one block are split into independently encoded blocks.
+	*/
+	constexpr std::uint8_t kContainerVersion = 3;
+
+	/**
+	* @brief Format flag: every block header holds a block type after the symbol count.
+	*
+	* Streams without it hold Huffman blocks only.
+	*/
+	constexpr std::uint8_t kBlockTypesFlag = 0x01;
+
+	/**
+	* @brief Format flag: the symbols of every Huffman block are split into kInterleavedStreams bitstreams.
+	*
+	* The block is cut into kInterleavedStreams segments of (symbolCount + 3) / 4 symbols, the last one
+	* shorter, each coded as a bitstream of its own. The payload format:
+	* - 32 bits per stream but the last: size of the stream in bytes, little-endian
+	* - The streams, one after another
+	*
+	* The decoder advances one reader per stream in the same loop, so the lookups of different
+	* streams do not wait on each other.
+	*/
+	constexpr std::uint8_t kInterleavedFlag = 0x02;
+
+	/**
+	* @brief Number of bitstreams of a block with kInterleavedFlag.
+	*/
+	constexpr std::size_t kInterleavedStreams = 4;
+
+	/**
+	* @brief Size of the stream size table of a block with kInterleavedFlag.
+	*/
+	constexpr std::size_t kJumpTableSize = 4 * (kInterleavedStreams - 1);
+
+	/**
+	* @brief Format flag: blocks may be kSharedTableBlocks, decodable only with the SharedTable they name.
+	*/
+	constexpr std::uint8_t kSharedTableFlag = 0x04;
+
+	/**
+	* @brief Format flags understood by the decoder.
+	*/
+	constexpr std::uint8_t kSupportedFlags = kBlockTypesFlag | kInterleavedFlag | kSharedTableFlag;
+
+	/**
+	* @brief Block type: the symbols follow unchanged.
+	*/
+	constexpr std::uint8_t kStoredBlock = 0;
+
+	/**
+	* @brief Block type: a single byte value repeated symbol count times.
+	*/
+	constexpr std::uint8_t kRleBlock = 1;
+
+	/**
+	* @brief Block type: code lengths followed by the Huffman coded symbols.
+	*/
+	constexpr std::uint8_t kHuffmanBlock = 2;
+
+	/**
+	* @brief Block type: symbols coded with a trained SharedTable, named by its id instead of code lengths.
+	*
+	* The symbols form a single bitstream, with or without kInterleavedFlag.
+	*/
+	constexpr std::uint8_t kSharedTableBlock = 3;
+
+	/**
+	* @brief Largest block coded with a SharedTable given to the encoder, larger blocks get a code of their own.
+	*
+	* Below this size the code lengths of a block's own code outweigh what the code saves
+	* over a trained one, so such blocks are packed without counting their symbols.
+	*/
+	constexpr std::size_t kSharedTableBlockLimit = 16 * 1024;
+
+	/**
+	* @brief First bytes of a file holding a SharedTable, see WriteSharedTable.
+	*/
+	constexpr char kSharedTableMagic[4] = { 'P', 'H', 'S', 'T' };
+
+	/**
+	* @brief Sampled entropy, in bits per byte, from which a block is stored without building a code.
+	*/
+	constexpr double kStoredBlockEntropy = 7.9;
+
+	/**
+	* @brief Largest size of a block header written by CreateHeader.
+	*/
+	constexpr std::size_t kMaxHeaderSize = Core::kMaxVarintSize + 1 + kAlphabetSize;
+
+	/**
+	* @brief Computes Huffman code lengths from symbol counts.
+	*
+	* Uses the in-place algorithm of Moffat and Katajainen on the counts sorted in a fixed-size
+	* array: a first pass pairs items into parent pointers, two more passes turn them into
+	* internal node depths and leaf depths. No tree is allocated.
+	*
+	* The lengths are optimal but unbounded. A single used symbol gets a 1-bit code.
+	*
+	* @param counts Number of occurrences of every symbol.
+	* @param alphabetSize Number of symbols, at most kMaxAlphabetSize.
+	* @param codeLengths Array of alphabetSize entries to store the code lengths in, 0 for absent symbols.
+	*/
+	void HuffmanCodeLengths(const std::uint64_t* counts, std::size_t alphabetSize, std::uint8_t* codeLengths);
+
+	/**
+	* @brief Computes optimal code lengths no longer than maxLength with the package-merge algorithm.
+	*
+	* For every length from maxLength down to 1 a list is formed by merging the symbols, sorted
+	* by count, with pairs of the next deeper list. Taking the 2n - 2 cheapest items of the
+	* length-1 list and following the selected pairs down, every symbol's code length is the
+	* number of lists in which it is selected. Runs on fixed-size arrays in O(n * maxLength).
+	*
+	* @param counts Number of occurrences of every symbol.
+	* @param alphabetSize Number of symbols, at most kMaxAlphabetSize.
+	* @param maxLength Longest allowed code length, 2^maxLength must cover the used symbols.
+	* @param codeLengths Array of alphabetSize entries to store the code lengths in, 0 for absent symbols.
+	*/
+	void PackageMergeCodeLengths(const std::uint64_t* counts, std::size_t alphabetSize, int maxLength, std::uint8_t* codeLengths);
+
+	/**
+	* @brief Computes code lengths no longer than maxLength.
+	*
+	* Huffman lengths are used when they fit, package-merge only when the limit is exceeded.
+	*/
+	void LimitedCodeLengths(const std::uint64_t* counts, std::size_t alphabetSize, int maxLength, std::uint8_t* codeLengths);
 
-		HuffmanNode* right;
+	/**
+	* @brief Assigns canonical codes to a set of code lengths.
+	*
+	* Codes are assigned in order of increasing length, symbols of equal length in
+	* increasing symbol order. The result is bit-reversed into stream order.
+	*
+	* @param codeLengths Code length of every symbol, 0 for absent symbols.
+	* @param alphabetSize Number of symbols.
+	* @param codes Array of alphabetSize entries to store the codes in.
+	*/
+	void AssignCanonicalCodes(const std::uint8_t* codeLengths, std::size_t alphabetSize, std::uint32_t* codes);
+
+	/**
+	* @brief Code of a symbol as used by the encoder, bits in stream order.
+	*/
+	struct EncodeEntry
+	{
+		std::uint32_t bits;
+
+		std::uint32_t length;
+	};
+
+	/**
+	* @brief A single prefix code.
+	*
+	* The code bits are kept in stream order: the first bit of the code is bit 0.
+	*/
+	struct CodeEntry
+	{
+		std::uint32_t bits;
+
+		std::uint8_t length;
+
+		std::uint16_t symbol;
+	};
+
+	/**
+	* @brief Multi-bit lookup table resolving whole symbols from the bit buffer.
+	*
+	* The first level is indexed by the next kLookupBits bits of the stream. Codes
+	* longer than that are resolved through a second-level table linked from the
+	* first-level entry of their prefix, sized by the longest code sharing that prefix.
+	*
+	* Entry layout: bits 0-5 code length (sub-table index bits for links), bit 6 link flag,
+	* bit 7 valid flag, bits 8-31 symbol (sub-table offset for links).
+	*/
+	class DecodeTable
+	{
 	public:
+		static constexpr std::uint32_t kLengthMask = 0x3F;
+
+		static constexpr std::uint32_t kSubTableFlag = 0x40;
+
+		static constexpr std::uint32_t kValidFlag = 0x80;
+
 		/**
-		* @brief Constructs a HuffmanNode with a character and weight.
+		* @brief Builds the table from a set of prefix codes.
+		*
+		* @param codes Codes to resolve, codes of length 0 are ignored.
 		*
-		* @param character The character stored in the node.
-		* @param weight The weight of the node.
+		* @throw Core::CompressionException if the codes are not prefix-free or too long.
 		*/
-		HuffmanNode(char character, int weight);
+		void build(const std::vector<CodeEntry>& codes);
 
 		/**
-		* @brief Constructs a HuffmanNode with left and right child nodes.
+		* @brief Builds the table for the canonical codes of a set of code lengths.
 		*
-		* @param l Pointer to the left child node.
-		* @param r Pointer to the right child node.
+		* @param codeLengths Code length of every symbol, 0 for absent symbols.
+		* @param alphabetSize Number of symbols.
+		*
+		* @throw Core::CompressionException if the lengths do not describe a prefix code.
 		*/
-		HuffmanNode(HuffmanNode* l, HuffmanNode* r);
+		void build(const std::uint8_t* codeLengths, std::size_t alphabetSize);
 
 		/**
-		* @brief Copy constructor.
+		* @brief Returns the table entry for the code at the front of the bit buffer without consuming it.
 		*
-		* @param other The HuffmanNode to copy.
+		* The reader must hold at least maxLength() bits.
 		*/
-		HuffmanNode(const HuffmanNode& other);
+		inline std::uint32_t lookup(const Core::BitReader& reader) const
+		{
+			std::uint32_t entry = entries[reader.peek(kLookupBits)];
+			if (entry & kSubTableFlag)
+			{
+				entry = entries[(entry >> 8) + (reader.peek(kLookupBits + (entry & kLengthMask)) >> kLookupBits)];
+			}
+			return entry;
+		}
 
 		/**
-		* @brief Static method to generate Huffman codes for leaf nodes.
+		* @brief Decodes and consumes one symbol, the reader must hold at least maxLength() bits.
 		*
-		* @param root Pointer to the root node of the Huffman tree.
-		* @param huffmanCode Map to store Huffman codes for characters.
-		* @param pom Temporary string for generating Huffman codes.
+		* @throw Core::CompressionException if the bits do not form a valid code.
 		*/
-		static void getLeaves(HuffmanNode* root, std::unordered_map<char, String>& huffmanaCode, String pom);
+		inline std::uint16_t decodeSymbol(Core::BitReader& reader) const
+		{
+			std::uint32_t entry = lookup(reader);
+			if (!(entry & kValidFlag)) throw Core::CompressionException("Invalid Huffman code");
+			reader.consume(entry & kLengthMask);
+			return static_cast<std::uint16_t>(entry >> 8);
+		}
 
 		/**
-		* @brief Destructor.
+		* @brief Returns the length of the longest code in the table.
 		*/
-		~HuffmanNode();
+		int maxLength() const { return longestCode; }
+
+		/**
+		* @brief Returns the length of the shortest code in the table.
+		*/
+		int minLength() const { return shortestCode; }
+
+		/**
+		* @brief Returns true if the table holds no codes.
+		*/
+		bool empty() const { return longestCode == 0; }
+
+	private:
+		std::vector<std::uint32_t> entries;
+
+		std::vector<std::uint32_t> canonicalCodes;
+
+		std::vector<CodeEntry> canonicalEntries;
+
+		int longestCode = 0;
+
+		int shortestCode = 0;
 	};
 
 	/**
-	* @brief Functor for comparing HuffmanNode pointers.
+	* @brief A code trained on a sample corpus and shared by many small inputs, see TrainSharedTable.
+	*
+	* Blocks coded with it store only its id: the encoder neither counts their symbols nor
+	* writes code lengths, and the decoder reuses the table built here instead of building
+	* one per block. Every byte value has a code, so any input can be coded with it.
 	*/
-	struct Comparator
+	class SharedTable
 	{
+	public:
 		/**
-		* @brief Compares two HuffmanNode pointers, left->weight > right->weight.
+		* @brief Builds the codes and the decode table of a set of code lengths.
+		*
+		* @param codeLengths Code length of every byte value, from 1 to kMaxCodeLengthLimit.
 		*
-		* @param left Pointer to the left HuffmanNode.
-		* @param right Pointer to the right HuffmanNode.
-		* @return True if the weight of the left node is greater than the weight of the right node, false otherwise.
+		* @throw Core::CompressionException if a byte value has no code or the lengths do not describe a prefix code.
+		*/
+		explicit SharedTable(const std::uint8_t* codeLengths);
+
+		/**
+		* @brief Returns the id stored in the blocks coded with the table, the Crc32 of its code lengths.
 		*/
-		bool operator()(HuffmanNode* left, HuffmanNode* right);
+		std::uint32_t id() const { return tableId; }
+
+		/**
+		* @brief Returns the code length of every byte value.
+		*/
+		const std::uint8_t* codeLengths() const { return lengths; }
+
+		/**
+		* @brief Returns the code of every byte value, as used by the encoder.
+		*/
+		const EncodeEntry* codes() const { return encodeTable; }
+
+		/**
+		* @brief Returns the table resolving the codes.
+		*/
+		const DecodeTable& decodeTable() const { return table; }
+
+	private:
+		std::uint32_t tableId;
+
+		std::uint8_t lengths[kAlphabetSize];
+
+		EncodeEntry encodeTable[kAlphabetSize];
+
+		DecodeTable table;
 	};
 
 	/**
-	* @brief Creates the header for Huffman encoding.
+	* @brief Trains a SharedTable on the byte counts of a sample corpus.
+	*
+	* Every byte value is counted once more than it occurs, so values absent from the
+	* corpus still get a code.
+	*
+	* @param counts Occurrences of every byte value in the corpus, kAlphabetSize entries.
+	* @param maxCodeLength Longest code length, clamped to [kMinCodeLengthLimit, kMaxCodeLengthLimit].
+	*/
+	SharedTable TrainSharedTable(const std::uint64_t* counts, int maxCodeLength = kDefaultCodeLengthLimit);
+
+	/**
+	* @brief Appends a table in its file format to output.
+	*
+	* The file format:
+	* - 4 bytes: kSharedTableMagic
+	* - 32 bits: id of the table, little-endian
+	* - Code lengths of the kAlphabetSize symbols, see WriteCodeLengths
+	*/
+	void WriteSharedTable(const SharedTable& table, std::vector<char>& output);
+
+	/**
+	* @brief Reads a table written by WriteSharedTable.
+	*
+	* @throw Core::CompressionException if the data is not a table or its id does not match its code lengths.
+	*/
+	SharedTable ReadSharedTable(std::span<const char> data);
+
+	/**
+	* @brief Writes the code lengths of an alphabet, one byte per token:
+	* - 00llllll: a single code length l
+	* - 01nnnnnn: n + 1 absent symbols
+	* - 10nnnnnn: the previous code length repeated n + 1 times
+	* - 11nnnnnn: 4 * (n + 1) absent symbols
+	*
+	* The canonical codes follow from the lengths, see AssignCanonicalCodes.
+	*
+	* @param output Buffer of at least alphabetSize bytes receiving the tokens.
+	* @param codeLengths Code length of every symbol.
+	* @param alphabetSize Number of symbols.
+	* @return The number of bytes written.
+	*/
+	std::size_t WriteCodeLengths(char* output, const std::uint8_t* codeLengths, std::size_t alphabetSize);
+
+	/**
+	* @brief Reads the code lengths written by WriteCodeLengths.
+	*
+	* @param data Pointer to the buffer.
+	* @param size The size of the buffer.
+	* @param offset Position of the first token.
+	* @param codeLengths Array of alphabetSize entries to store the code lengths in.
+	* @param alphabetSize Number of symbols.
+	* @return The position after the last token.
+	*
+	* @throw Core::CompressionException if the data format is invalid.
+	*/
+	std::size_t ReadCodeLengths(const char* data, std::size_t size, std::size_t offset, std::uint8_t* codeLengths, std::size_t alphabetSize);
+
+	/**
+	* @brief Creates the header of a block.
 	*
 	* The header format:
-	* - 8 bits: bits to trim from the last byte
-	* - 16 bits: number of Huffman codes
-	* - For each code:
-	*   - 8 bits: character
-	*   - 8 bits: number of bits in the code
-	*   - Actual bits representing the code
+	* - varint: number of encoded symbols
+	* - 8 bits: block type
+	* - kHuffmanBlock: code lengths of the kAlphabetSize symbols, see WriteCodeLengths
+	* - kSharedTableBlock: 32 bits, id of the SharedTable, little-endian
 	*
-	* @param encodedBits Vector to store the encoded header bits.
-	* @param huffmanCodes Map containing Huffman codes for characters.
-	* @param bitIndex Reference to the current bit index within the byte.
-	* @param byteIndex Reference to the current byte index within the vector.
+	* @param header Buffer of at least kMaxHeaderSize bytes receiving the header.
+	* @param blockType kStoredBlock, kRleBlock, kHuffmanBlock or kSharedTableBlock.
+	* @param codeLengths Code length of every symbol, only read for kHuffmanBlock.
+	* @param symbolCount Number of symbols in the encoded data.
+	* @param tableId Id of the SharedTable, only written for kSharedTableBlock.
+	* @return The size of the header in bytes.
+	*/
+	std::size_t CreateHeader(char* header, std::uint8_t blockType, const std::uint8_t* codeLengths, std::uint64_t symbolCount, std::uint32_t tableId = 0);
+
+	/**
+	* @brief Reads the header written by CreateHeader.
+	*
+	* Without kBlockTypesFlag the header has no block type byte and the block is a kHuffmanBlock.
+	*
+	* @param block Pointer to the encoded block.
+	* @param blockSize The size of the encoded block.
+	* @param flags Format flags of the stream.
+	* @param codeLengths Array of kAlphabetSize entries to store the code lengths of a kHuffmanBlock or kSharedTableBlock in.
+	* @param symbolCount Reference to store the number of encoded symbols.
+	* @param blockType Reference to store the block type.
+	* @param sharedTable The table kSharedTableBlocks must name, nullptr if none was given.
+	* @return The size of the header in bytes.
+	*
+	* @throw Core::CompressionException if the data format is invalid or a kSharedTableBlock names another table.
+	*/
+	std::size_t ReadHeader(const char* block, std::size_t blockSize, std::uint8_t flags, std::uint8_t* codeLengths, std::uint64_t& symbolCount, std::uint8_t& blockType,
+		const SharedTable* sharedTable = nullptr);
+
+	/**
+	* @brief Returns the largest size of a block encoding dataSize bytes.
 	*
-	* @throw Core::CompressionException if there are too many symbols to encode.
+	* Blocks that Huffman coding would not shrink are stored, so the payload never exceeds dataSize bytes.
 	*/
-	void CreateHeader(std::vector<std::bitset<8>>& encodedBits, const std::unordered_map<char, String>& huffmanCodes, int& bitIndex, std::size_t& byteIndex);
+	constexpr std::size_t BlockBound(std::size_t dataSize) { return kMaxHeaderSize + dataSize; }
 
 	/**
-	* @brief Reads the header for Huffman encoding.
+	* @brief Encodes one block through a temporary HuffmanEncoder, see HuffmanEncoder::encodeBlock.
+	*
+	* @param data Pointer to the data to be encoded.
+	* @param dataSize The size of the data.
+	* @param encodedBlock Vector to append the encoded block to.
+	* @param maxCodeLength Longest code length the encoder may use.
+	* @param interleaved Whether Huffman blocks are split into streams, the stream must then set kInterleavedFlag.
+	* @param sharedTable Table coding blocks up to kSharedTableBlockLimit, the stream must then set kSharedTableFlag.
+	*
+	* @throw Core::CompressionException if there is an error during encoding.
+	*/
+	void EncodeBlock(const char* data, std::size_t dataSize, std::vector<char>& encodedBlock, int maxCodeLength = kDefaultCodeLengthLimit, bool interleaved = false,
+		std::shared_ptr<const SharedTable> sharedTable = nullptr);
+
+	/**
+	* @brief Decodes one block through a temporary HuffmanDecoder, see HuffmanDecoder::decodeBlock.
+	*
+	* @param block Pointer to the encoded block.
+	* @param blockSize The size of the encoded block.
+	* @param output Pointer to the buffer receiving the decoded data.
+	* @param outputSize The number of symbols the block must decode to.
+	* @param flags Format flags of the stream holding the block.
+	* @param sharedTable The table the stream was encoded with, nullptr if none.
+	*
+	* @throw Core::CompressionException if the block is malformed.
+	*/
+	void DecodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize, std::uint8_t flags,
+		std::shared_ptr<const SharedTable> sharedTable = nullptr);
+
+	/**
+	* @brief Reads the header of the legacy, unversioned Huffman format.
 	*
 	* The header format:
 	* - 8 bits: bits to trim from the last byte
@@ -106,48 +513,247 @@ namespace Huffman
 	*   - 8 bits: number of bits in the code
 	*   - Actual bits representing the code
 	*
-	* @param encodedBits Vector containing the encoded header bits.
-	* @param huffmanCodes Map to store Huffman codes for characters.
-	* @param bitIndex Reference to the current bit index within the byte.
-	* @param byteIndex Reference to the current byte index within the vector.
+	* @param encodedBytes The encoded data.
+	* @param codes Vector to store the Huffman codes in.
+	* @param headerBits Reference to store the bit position where the encoded data begins.
 	* @return The number of bits to trim from the last byte.
 	*
 	* @throw Core::CompressionException if the data format is invalid.
 	*/
-	int ReadHeader(std::vector<std::bitset<8>>& encodedBits, const std::unordered_map<String, char>& huffmanCodes, int& bitIndex, std::size_t& byteIndex);
+	int ReadLegacyHeader(std::span<const char> encodedBytes, std::vector<CodeEntry>& codes, std::size_t& headerBits);
 
 	/**
-	* @brief A class containing Huffman compression method.
+	* @brief Reusable Huffman encoder keeping its histogram, code tables and scratch buffer between calls.
 	*/
-	class HuffmanCompression : public Core::CompressionMethod
+	class HuffmanEncoder : public Core::EncoderContext
 	{
 	public:
+		/**
+		* @brief Constructs the encoder.
+		*
+		* @param blockSize Amount of input per independently encoded block.
+		* @param threadCount Number of threads encoding the blocks of large inputs, or counting the symbols of a large single block.
+		* @param maxCodeLength Longest code length the encoder may use.
+		* @param interleaved Whether Huffman blocks are split into kInterleavedStreams streams.
+		* @param sharedTable Table coding blocks up to kSharedTableBlockLimit, nullptr for none.
+		*/
+		HuffmanEncoder(std::size_t blockSize, unsigned threadCount, int maxCodeLength = kDefaultCodeLengthLimit, bool interleaved = true,
+			std::shared_ptr<const SharedTable> sharedTable = nullptr);
 
-		HuffmanCompression() = default;
+		/**
+		* @brief Encodes data into a caller-provided buffer.
+		*
+		* Inputs fitting in one block are written as a single canonical stream without allocating,
+		* larger inputs are split into blocks with their own code tables, encoded on threadCount
+		* threads and framed into a block container with a block index.
+		*
+		* @throw Core::CompressionException if the buffer is too small or there is an error during encoding.
+		*/
+		std::size_t encode(std::span<const std::byte> data, std::span<std::byte> encodedData) override;
 
 		/**
-		* @brief encodes the given data using Huffman coding.
+		* @brief Encodes one block: the header from CreateHeader followed by the coded bits.
+		*
+		* Codes are packed through a 64-bit accumulator, straight into the output when it has
+		* room for the accumulator's slack, through the scratch buffer otherwise.
 		*
-		* @param data The shared pointer to the data to be encoded.
+		* A block whose sampled entropy reaches kStoredBlockEntropy, or that the code would not
+		* shrink, is stored without counting or packing. A block of one repeated byte is written
+		* as a kRleBlock. With a shared table, blocks up to kSharedTableBlockLimit are packed with
+		* it straight away and stored only if that does not shrink them.
+		*
+		* @param data Pointer to the data to be encoded.
 		* @param dataSize The size of the data.
-		* @param encodedData Vector to store the encoded data.
+		* @param encodedBlock Buffer receiving the encoded block, BlockBound(dataSize) bytes always suffice.
+		* @param capacity The size of the buffer.
+		* @return The size of the encoded block.
 		*
-		* This function performs Huffman encoding on the input data and stores the encoded bits in the provided vector.
+		* @throw Core::CompressionException if the buffer is too small or there is an error during encoding.
+		*/
+		std::size_t encodeBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity);
+
+	private:
+		/**
+		* @brief Encodes a block as a kSharedTableBlock, or stores it if the shared codes do not shrink it.
+		*/
+		std::size_t encodeSharedBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity);
+
+		std::size_t blockSize;
+
+		unsigned threadCount;
+
+		int maxCodeLength;
+
+		bool interleaved;
+
+		std::shared_ptr<const SharedTable> sharedTable;
+
+		std::uint64_t counts[kAlphabetSize];
+
+		std::uint8_t codeLengths[kAlphabetSize];
+
+		EncodeEntry table[kAlphabetSize];
+
+		std::vector<char> scratch;
+	};
+
+	/**
+	* @brief Reusable Huffman decoder keeping its decode table and scratch buffers between calls.
+	*/
+	class HuffmanDecoder : public Core::DecoderContext
+	{
+	public:
+		/**
+		* @brief Constructs the decoder.
+		*
+		* @param threadCount Number of threads decoding blocks of block containers concurrently.
+		* @param sharedTable The table the data was encoded with, nullptr if none.
+		*/
+		explicit HuffmanDecoder(unsigned threadCount, std::shared_ptr<const SharedTable> sharedTable = nullptr);
+
+		/**
+		* @brief Returns the decoded size stored in the stream header.
+		*
+		* Legacy streams do not store it, they are decoded into the scratch buffer and kept for the next decode.
+		*
+		* @throw Core::CompressionException if the data format is invalid.
+		*/
+		std::size_t decodedSize(std::span<const std::byte> encodedData) override;
+
+		/**
+		* @brief Decodes data into a caller-provided buffer.
+		*
+		* Both the canonical formats and the legacy format are accepted.
+		*
+		* @throw Core::CompressionException if the buffer is too small or there is an error during decoding.
+		*/
+		std::size_t decode(std::span<const std::byte> encodedData, std::span<std::byte> data) override;
+
+		/**
+		* @brief Decodes one block written by HuffmanEncoder::encodeBlock.
+		*
+		* Symbols are resolved with a multi-bit lookup table built from the code lengths in the header.
+		* Stored and RLE blocks are copied and filled without touching the table, kSharedTableBlocks
+		* are resolved with the table of the shared table.
+		*
+		* @param block Pointer to the encoded block.
+		* @param blockSize The size of the encoded block.
+		* @param output Pointer to the buffer receiving the decoded data.
+		* @param outputSize The number of symbols the block must decode to.
+		* @param flags Format flags of the stream holding the block.
+		*
+		* @throw Core::CompressionException if the block is malformed.
+		*/
+		void decodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize, std::uint8_t flags);
+
+	private:
+		/**
+		* @brief Decodes a stream in the legacy format with explicit codes in the header into the scratch buffer.
+		*/
+		void decodeLegacy(std::span<const char> dataToDecode);
+
+		unsigned threadCount;
+
+		std::shared_ptr<const SharedTable> sharedTable;
+
+		DecodeTable table;
+
+		std::vector<CodeEntry> codes;
+
+		std::vector<char> legacyOutput;
+
+		/**< The legacy stream whose decoded data is held in legacyOutput. */
+		std::span<const char> legacyInput;
+	};
+
+	/**
+	* @brief A class containing Huffman compression method.
+	*/
+	class HuffmanCompression : public Core::CompressionMethod, public Core::StreamCompressionMethod
+	{
+	public:
+
+		/**
+		* @brief Constructs the method.
+		*
+		* @param blockSize Amount of input per independently encoded block.
+		* @param threadCount Number of threads encoding and decoding blocks concurrently.
+		* @param memoryBudget Bytes the streaming encoder and decoder may use for blocks in flight.
+		* @param maxCodeLength Longest code length the encoder may use, clamped to [kMinCodeLengthLimit, kMaxCodeLengthLimit].
+		* @param interleaved Whether Huffman blocks are split into kInterleavedStreams streams for faster decoding.
+		* @param sharedTable Trained table coding small blocks and decoding the blocks coded with it, nullptr for none.
+		*/
+		explicit HuffmanCompression(std::size_t blockSize = Core::kDefaultBlockSize, unsigned threadCount = 1, std::size_t memoryBudget = Core::kDefaultMemoryBudget,
+			int maxCodeLength = kDefaultCodeLengthLimit, bool interleaved = true, std::shared_ptr<const SharedTable> sharedTable = nullptr);
+
+		/**
+		* @brief Returns the largest encoded size of dataSize bytes, including the bit writer's slack.
+		*/
+		std::size_t compressBound(std::size_t dataSize) const override;
+
+		/**
+		* @brief Creates a HuffmanEncoder with this method's block size, thread count, code length limit and shared table.
+		*/
+		std::unique_ptr<Core::EncoderContext> createEncoder() const override;
+
+		/**
+		* @brief Creates a HuffmanDecoder with this method's thread count and shared table.
+		*/
+		std::unique_ptr<Core::DecoderContext> createDecoder() const override;
+
+		/**
+		* @brief Decodes only the bytes [offset, offset + length) of the original data.
+		*
+		* For block containers only the blocks covering the range are decoded, on threadCount threads.
+		*
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const override;
+
+		/**
+		* @brief Encodes a stream in blocks, keeping at most memoryBudget bytes of blocks in flight.
+		*
+		* The output is identical to encode on the whole input.
 		*
 		* @throw Core::CompressionException if there is an error during encoding.
 		*/
-		void encode(const std::shared_ptr<char>& data, std::size_t dataSize, std::vector<std::bitset<8>>& encodedData) const override;
+		void encodeStream(std::istream& input, std::ostream& output) const override;
 
 		/**
-		* @brief decodes the given encoded data using Huffman coding.
+		* @brief Decodes a stream written by encode or encodeStream.
 		*
-		* @param dataToDecode The vector containing the encoded data to be decoded.
-		* @param data Vector to store the decoded data.
+		* Block containers are decoded block by block in bounded memory, single-block and legacy
+		* streams are read whole.
 		*
-		* This function decodes the input data using the provided Huffman codes and stores the decoded characters in the output vector.
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeStream(std::istream& input, std::ostream& output) const override;
+
+		/**
+		* @brief Encodes an input already in memory, block by block straight from the input view.
+		*
+		* @throw Core::CompressionException if there is an error during encoding.
+		*/
+		void encodeStream(std::span<const char> input, std::ostream& output) const override;
+
+		/**
+		* @brief Decodes an input already in memory, block containers in ranges bounded by memoryBudget.
 		*
 		* @throw Core::CompressionException if there is an error during decoding.
 		*/
-		void decode(const std::vector<std::bitset<8>>& dataToDecode, std::vector<char>& data) const override;
+		void decodeStream(std::span<const char> input, std::ostream& output) const override;
+
+	private:
+		std::size_t blockSize;
+
+		unsigned threadCount;
+
+		std::size_t memoryBudget;
+
+		int maxCodeLength;
+
+		bool interleaved;
+
+		std::shared_ptr<const SharedTable> sharedTable;
 	};
 }
\ No newline at end of file
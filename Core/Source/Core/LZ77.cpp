@@ -0,0 +1,576 @@
+#include "LZ77.h"
+#include "Histogram.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <istream>
+#include <ostream>
+
+namespace LZ77
+{
+	static constexpr int kHashBits = 15;
+
+	/**< Matches at least this long are taken without looking for a longer one at the next position. */
+	static constexpr std::size_t kLazyLength = 32;
+
+	/**< Minimum-length matches further than this cost more than their literals. */
+	static constexpr std::size_t kTooFar = 4096;
+
+	static inline std::uint32_t HashPosition(const std::uint8_t* data)
+	{
+		std::uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+		return (value * 2654435761u) >> (32 - kHashBits);
+	}
+
+	static inline std::size_t MatchLength(const std::uint8_t* candidate, const std::uint8_t* current, std::size_t maxLength)
+	{
+		std::size_t length = 0;
+		while (length + 8 <= maxLength)
+		{
+			std::uint64_t difference = Core::LoadLE64(candidate + length) ^ Core::LoadLE64(current + length);
+			if (difference != 0) return length + (std::countr_zero(difference) >> 3);
+			length += 8;
+		}
+		while (length < maxLength && candidate[length] == current[length]) length++;
+		return length;
+	}
+
+	static void BuildEncodeTable(const std::uint8_t* codeLengths, std::size_t alphabetSize, Huffman::EncodeEntry* table)
+	{
+		std::uint32_t codes[Huffman::kMaxAlphabetSize];
+		Huffman::AssignCanonicalCodes(codeLengths, alphabetSize, codes);
+		for (std::size_t symbol = 0; symbol < alphabetSize; symbol++)
+		{
+			table[symbol] = { codes[symbol], codeLengths[symbol] };
+		}
+	}
+
+	void EncodeBlock(const char* data, std::size_t dataSize, std::vector<char>& encodedBlock, int windowLog, unsigned searchDepth)
+	{
+		LZ77Encoder encoder(dataSize, 1, windowLog, searchDepth);
+
+		std::size_t offset = encodedBlock.size();
+		encodedBlock.resize(offset + BlockBound(dataSize) + 8);
+		encodedBlock.resize(offset + encoder.encodeBlock(data, dataSize, encodedBlock.data() + offset, encodedBlock.size() - offset));
+	}
+
+	void DecodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize)
+	{
+		LZ77Decoder decoder(1);
+		decoder.decodeBlock(block, blockSize, output, outputSize);
+	}
+
+	LZ77Encoder::LZ77Encoder(std::size_t blockSize, unsigned threadCount, int windowLog, unsigned searchDepth)
+		: blockSize(std::max<std::size_t>(blockSize, 1)), threadCount(std::max(threadCount, 1u)),
+		windowLog(std::clamp(windowLog, kMinWindowLog, kMaxWindowLog)), searchDepth(std::max(searchDepth, 1u)),
+		head(std::size_t(1) << kHashBits, 0),
+		chain(std::min(std::size_t(1) << this->windowLog, std::bit_ceil(this->blockSize)), 0) {}
+
+	std::size_t LZ77Encoder::encode(std::span<const std::byte> data, std::span<std::byte> encodedData)
+	{
+		const char* input = reinterpret_cast<const char*>(data.data());
+		char* output = reinterpret_cast<char*>(encodedData.data());
+
+		if (data.size() <= blockSize)
+		{
+			if (encodedData.size() < 2) throw Core::CompressionException("Output buffer too small");
+
+			output[0] = static_cast<char>(Huffman::kFormatMarker | kFormatVersion);
+			output[1] = 0;
+
+			Core::BlockTimer timer(data.size());
+			std::size_t size = 2 + encodeBlock(input, data.size(), output + 2, encodedData.size() - 2);
+			timer.stop(size);
+			return size;
+		}
+
+		auto encodeBlock = [this](const char* block, std::size_t size, std::vector<char>& encodedBlock)
+		{
+			EncodeBlock(block, size, encodedBlock, windowLog, searchDepth);
+		};
+
+		std::vector<char> container;
+		Core::EncodeBlocks(Huffman::kFormatMarker | kContainerVersion, 0, input, data.size(), blockSize, threadCount, encodeBlock, container);
+		if (container.size() > encodedData.size()) throw Core::CompressionException("Output buffer too small");
+
+		std::copy(container.begin(), container.end(), output);
+		return container.size();
+	}
+
+	std::size_t LZ77Encoder::encodeBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity)
+	{
+		const std::uint8_t* input = reinterpret_cast<const std::uint8_t*>(data);
+
+		{
+			Core::ScopedTimer timer(Core::Phase::MatchFinding);
+			findTokens(input, dataSize);
+		}
+
+		std::uint64_t payloadBits = extraBitCount;
+		{
+			Core::ScopedTimer timer(Core::Phase::CodeLengths);
+			Huffman::LimitedCodeLengths(literalCounts, kLiteralAlphabetSize, Huffman::kDefaultCodeLengthLimit, literalLengths);
+			Huffman::LimitedCodeLengths(distanceCounts, kDistanceAlphabetSize, Huffman::kDefaultCodeLengthLimit, distanceLengths);
+
+			for (std::size_t symbol = 0; symbol < kLiteralAlphabetSize; symbol++) payloadBits += literalCounts[symbol] * literalLengths[symbol];
+			for (std::size_t symbol = 0; symbol < kDistanceAlphabetSize; symbol++) payloadBits += distanceCounts[symbol] * distanceLengths[symbol];
+		}
+
+		// Short matches in data without long repeats can cost more than the literals they replace.
+		std::uint64_t byteCounts[256];
+		std::uint8_t byteLengths[256];
+		{
+			Core::ScopedTimer timer(Core::Phase::Histogram);
+			Core::CountBytes(input, dataSize, byteCounts);
+		}
+		{
+			Core::ScopedTimer timer(Core::Phase::CodeLengths);
+			Huffman::LimitedCodeLengths(byteCounts, 256, Huffman::kDefaultCodeLengthLimit, byteLengths);
+		}
+
+		std::uint64_t literalBits = 0;
+		for (std::size_t symbol = 0; symbol < 256; symbol++) literalBits += byteCounts[symbol] * byteLengths[symbol];
+		if (literalBits < payloadBits)
+		{
+			tokens.clear();
+			for (std::size_t i = 0; i < dataSize; i++) tokens.push_back({ 0, input[i] });
+
+			std::copy_n(byteCounts, 256, literalCounts);
+			std::fill_n(literalCounts + 256, kLengthCodes, 0);
+			std::fill_n(distanceCounts, kDistanceAlphabetSize, 0);
+			std::copy_n(byteLengths, 256, literalLengths);
+			std::fill_n(literalLengths + 256, kLengthCodes, 0);
+			std::fill_n(distanceLengths, kDistanceAlphabetSize, 0);
+			payloadBits = literalBits;
+		}
+
+		char header[Core::kMaxVarintSize + 1 + kLiteralAlphabetSize + kDistanceAlphabetSize];
+		std::size_t sizeLength = Core::WriteVarint(header, dataSize);
+		std::size_t headerSize = sizeLength;
+		{
+			Core::ScopedTimer timer(Core::Phase::Header);
+			header[headerSize++] = static_cast<char>(kCompressedBlock);
+			headerSize += Huffman::WriteCodeLengths(header + headerSize, literalLengths, kLiteralAlphabetSize);
+			headerSize += Huffman::WriteCodeLengths(header + headerSize, distanceLengths, kDistanceAlphabetSize);
+		}
+
+		std::size_t encodedSize = headerSize + (payloadBits + 7) / 8;
+		std::size_t storedSize = sizeLength + 1 + dataSize;
+		if (encodedSize >= storedSize)
+		{
+			if (storedSize > capacity) throw Core::CompressionException("Output buffer too small");
+
+			header[sizeLength] = static_cast<char>(kStoredBlock);
+			std::copy_n(header, sizeLength + 1, encodedBlock);
+			std::copy_n(data, dataSize, encodedBlock + sizeLength + 1);
+
+			Core::AddCounter(Core::Counter::HeaderBytes, sizeLength + 1);
+			Core::AddCounter(Core::Counter::StoredBlocks, 1);
+			return storedSize;
+		}
+		if (encodedSize > capacity) throw Core::CompressionException("Output buffer too small");
+
+		Core::ScopedTimer timer(Core::Phase::Packing);
+		Core::AddCounter(Core::Counter::Symbols, tokens.size());
+		Core::AddCounter(Core::Counter::CodedBits, payloadBits);
+		Core::AddCounter(Core::Counter::HeaderBytes, headerSize);
+		Core::MaxCounter(Core::Counter::MaxCodeLength, std::max(*std::max_element(literalLengths, literalLengths + kLiteralAlphabetSize),
+			*std::max_element(distanceLengths, distanceLengths + kDistanceAlphabetSize)));
+
+		BuildEncodeTable(literalLengths, kLiteralAlphabetSize, literalTable);
+		BuildEncodeTable(distanceLengths, kDistanceAlphabetSize, distanceTable);
+
+		char* payload = encodedBlock + headerSize;
+		if (capacity - encodedSize < 8)
+		{
+			scratch.resize(encodedSize - headerSize + 8);
+			payload = scratch.data();
+		}
+
+		Core::BitWriter writer(reinterpret_cast<std::uint8_t*>(payload));
+		for (const Token& token : tokens)
+		{
+			if (token.length == 0)
+			{
+				const Huffman::EncodeEntry& code = literalTable[token.value];
+				writer.write(code.bits, code.length);
+				writer.flush();
+				continue;
+			}
+
+			int extraBits;
+			std::uint32_t lengthValue = token.length - kMinMatch;
+			const Huffman::EncodeEntry& lengthCode = literalTable[256 + BucketCode(lengthValue, extraBits)];
+			writer.write(lengthCode.bits, lengthCode.length);
+			writer.write(lengthValue & ((std::uint32_t(1) << extraBits) - 1), extraBits);
+			writer.flush();
+
+			std::uint32_t distanceValue = token.value - 1;
+			const Huffman::EncodeEntry& distanceCode = distanceTable[BucketCode(distanceValue, extraBits)];
+			writer.write(distanceCode.bits, distanceCode.length);
+			writer.write(distanceValue & ((std::uint32_t(1) << extraBits) - 1), extraBits);
+			writer.flush();
+		}
+
+		std::size_t payloadSize = writer.finish();
+		if (payload != encodedBlock + headerSize) std::copy_n(payload, payloadSize, encodedBlock + headerSize);
+		std::copy_n(header, headerSize, encodedBlock);
+
+		return headerSize + payloadSize;
+	}
+
+	void LZ77Encoder::findTokens(const std::uint8_t* data, std::size_t size)
+	{
+		tokens.clear();
+		std::fill_n(literalCounts, kLiteralAlphabetSize, 0);
+		std::fill_n(distanceCounts, kDistanceAlphabetSize, 0);
+		extraBitCount = 0;
+
+		if (size >= UINT32_MAX - positionBase)
+		{
+			std::fill(head.begin(), head.end(), 0);
+			positionBase = 0;
+		}
+
+		auto literal = [&](std::size_t position)
+		{
+			tokens.push_back({ 0, data[position] });
+			literalCounts[data[position]]++;
+		};
+
+		auto match = [&](std::size_t length, std::size_t distance)
+		{
+			int lengthExtra, distanceExtra;
+			literalCounts[256 + BucketCode(static_cast<std::uint32_t>(length - kMinMatch), lengthExtra)]++;
+			distanceCounts[BucketCode(static_cast<std::uint32_t>(distance - 1), distanceExtra)]++;
+			extraBitCount += lengthExtra + distanceExtra;
+			tokens.push_back({ static_cast<std::uint32_t>(length), static_cast<std::uint32_t>(distance) });
+		};
+
+		std::size_t position = 0;
+		std::size_t length = 0;
+		std::size_t distance = 0;
+		bool pending = false;
+		while (position < size)
+		{
+			if (!pending)
+			{
+				length = 0;
+				if (position + kMinMatch <= size)
+				{
+					length = findMatch(data, size, position, distance);
+					insert(data, position);
+				}
+			}
+			pending = false;
+
+			if (length == 0)
+			{
+				literal(position++);
+				continue;
+			}
+
+			std::size_t inserted = position + 1;
+			if (length < kLazyLength && position + 1 + kMinMatch <= size)
+			{
+				std::size_t nextDistance = 0;
+				std::size_t nextLength = findMatch(data, size, position + 1, nextDistance);
+				insert(data, position + 1);
+				inserted++;
+
+				if (nextLength > length)
+				{
+					literal(position++);
+					length = nextLength;
+					distance = nextDistance;
+					pending = true;
+					continue;
+				}
+			}
+
+			match(length, distance);
+			for (std::size_t next = inserted; next < position + length && next + kMinMatch <= size; next++) insert(data, next);
+			position += length;
+		}
+
+		positionBase += static_cast<std::uint32_t>(size) + 1;
+	}
+
+	std::size_t LZ77Encoder::findMatch(const std::uint8_t* data, std::size_t size, std::size_t position, std::size_t& distance) const
+	{
+		const std::size_t maxLength = std::min(kMaxMatch, size - position);
+		const std::size_t windowMask = chain.size() - 1;
+
+		std::size_t bestLength = 0;
+		std::uint32_t stored = head[HashPosition(data + position)];
+		for (unsigned depth = searchDepth; depth > 0 && stored > positionBase; depth--)
+		{
+			std::size_t candidate = stored - positionBase - 1;
+			std::size_t candidateDistance = position - candidate;
+			if (candidateDistance >= chain.size()) break;
+
+			if (data[candidate + bestLength] == data[position + bestLength])
+			{
+				std::size_t length = MatchLength(data + candidate, data + position, maxLength);
+				if (length > bestLength)
+				{
+					bestLength = length;
+					distance = candidateDistance;
+					if (length == maxLength) break;
+				}
+			}
+
+			stored = chain[candidate & windowMask];
+		}
+
+		if (bestLength < kMinMatch || (bestLength == kMinMatch && distance > kTooFar)) return 0;
+		return bestLength;
+	}
+
+	void LZ77Encoder::insert(const std::uint8_t* data, std::size_t position)
+	{
+		std::uint32_t& bucket = head[HashPosition(data + position)];
+		chain[position & (chain.size() - 1)] = bucket;
+		bucket = positionBase + static_cast<std::uint32_t>(position) + 1;
+	}
+
+	LZ77Decoder::LZ77Decoder(unsigned threadCount) : threadCount(std::max(threadCount, 1u)) {}
+
+	std::size_t LZ77Decoder::decodedSize(std::span<const std::byte> encodedData)
+	{
+		std::span<const char> input(reinterpret_cast<const char*>(encodedData.data()), encodedData.size());
+		if (input.empty()) throw Core::CompressionException("Invalid data format");
+
+		switch (static_cast<std::uint8_t>(input[0]))
+		{
+			case Huffman::kFormatMarker | kFormatVersion:
+			{
+				if (input.size() < 3) throw Core::CompressionException("Invalid data format");
+				if (input[1] != 0) throw Core::CompressionException("Unsupported format flags");
+
+				std::size_t offset = 2;
+				std::size_t dataSize = Core::ReadVarint(input.data(), input.size(), offset);
+				// Every match takes at least two bits, a literal/length code and a distance code.
+				if (dataSize / kMaxMatch > (input.size() - 2) * 4) throw Core::CompressionException("Invalid data format");
+
+				return dataSize;
+			}
+
+			case Huffman::kFormatMarker | kContainerVersion:
+			{
+				Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+				if (index.flags != 0) throw Core::CompressionException("Unsupported format flags");
+
+				return index.originalSize;
+			}
+
+			default:
+				throw Core::CompressionException("Unsupported format version");
+		}
+	}
+
+	std::size_t LZ77Decoder::decode(std::span<const std::byte> encodedData, std::span<std::byte> data)
+	{
+		std::size_t size = decodedSize(encodedData);
+		if (size > data.size()) throw Core::CompressionException("Output buffer too small");
+
+		std::span<const char> input(reinterpret_cast<const char*>(encodedData.data()), encodedData.size());
+		char* output = reinterpret_cast<char*>(data.data());
+
+		if (static_cast<std::uint8_t>(input[0]) == (Huffman::kFormatMarker | kFormatVersion))
+		{
+			Core::BlockTimer timer(input.size());
+			decodeBlock(input.data() + 2, input.size() - 2, output, size);
+			timer.stop(size);
+		}
+		else
+		{
+			Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+			Core::DecodeBlocks(input.data(), index, 0, index.originalSize, output, threadCount, DecodeBlock);
+		}
+
+		return size;
+	}
+
+	void LZ77Decoder::decodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize)
+	{
+		std::size_t offset = 0;
+		std::uint64_t dataSize = Core::ReadVarint(block, blockSize, offset);
+		if (dataSize != outputSize) throw Core::CompressionException("Block size does not match the block index");
+		if (offset >= blockSize) throw Core::CompressionException("Invalid data format");
+
+		std::uint8_t blockType = static_cast<std::uint8_t>(block[offset++]);
+		if (blockType == kStoredBlock)
+		{
+			if (blockSize - offset != outputSize) throw Core::CompressionException("Invalid data format");
+			std::copy_n(block + offset, outputSize, output);
+			return;
+		}
+		if (blockType != kCompressedBlock) throw Core::CompressionException("Invalid data format");
+
+		std::uint8_t literalLengths[kLiteralAlphabetSize];
+		std::uint8_t distanceLengths[kDistanceAlphabetSize];
+		{
+			Core::ScopedTimer timer(Core::Phase::Header);
+			offset = Huffman::ReadCodeLengths(block, blockSize, offset, literalLengths, kLiteralAlphabetSize);
+			offset = Huffman::ReadCodeLengths(block, blockSize, offset, distanceLengths, kDistanceAlphabetSize);
+		}
+		{
+			Core::ScopedTimer timer(Core::Phase::CodeLengths);
+			literalTable.build(literalLengths, kLiteralAlphabetSize);
+			distanceTable.build(distanceLengths, kDistanceAlphabetSize);
+		}
+		if (outputSize == 0) return;
+		if (literalTable.empty()) throw Core::CompressionException("Invalid data format");
+
+		Core::ScopedTimer timer(Core::Phase::Unpacking);
+		const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(block);
+		Core::BitReader reader(bytes + offset, blockSize - offset);
+
+		std::size_t outputIndex = 0;
+		while (outputIndex < outputSize)
+		{
+			reader.refill();
+			std::uint32_t symbol = literalTable.decodeSymbol(reader);
+			if (symbol < 256)
+			{
+				output[outputIndex++] = static_cast<char>(symbol);
+				continue;
+			}
+
+			int extraBits;
+			std::size_t length = kMinMatch + BucketBase(symbol - 256, extraBits);
+			length += reader.peek(extraBits);
+			reader.consume(extraBits);
+
+			if (distanceTable.empty()) throw Core::CompressionException("Invalid data format");
+			reader.refill();
+			std::size_t distance = 1 + BucketBase(distanceTable.decodeSymbol(reader), extraBits);
+			distance += reader.peek(extraBits);
+			reader.consume(extraBits);
+
+			if (distance > outputIndex || length > outputSize - outputIndex) throw Core::CompressionException("Invalid data format");
+
+			char* destination = output + outputIndex;
+			const char* source = destination - distance;
+			if (distance >= 8 && length + 8 <= outputSize - outputIndex)
+			{
+				for (std::size_t i = 0; i < length; i += 8) std::memcpy(destination + i, source + i, 8);
+			}
+			else
+			{
+				for (std::size_t i = 0; i < length; i++) destination[i] = source[i];
+			}
+			outputIndex += length;
+		}
+
+		if (reader.overflowed()) throw Core::CompressionException("Invalid data format");
+	}
+
+	LZ77Compression::LZ77Compression(std::size_t blockSize, unsigned threadCount, std::size_t memoryBudget, int windowLog, unsigned searchDepth)
+		: blockSize(std::clamp<std::size_t>(blockSize, 1, Core::kMaxBlockSize)), threadCount(std::max(threadCount, 1u)), memoryBudget(memoryBudget),
+		windowLog(std::clamp(windowLog, kMinWindowLog, kMaxWindowLog)), searchDepth(std::max(searchDepth, 1u)) {}
+
+	std::size_t LZ77Compression::compressBound(std::size_t dataSize) const
+	{
+		if (dataSize <= blockSize) return 2 + BlockBound(dataSize) + 8;
+
+		return Core::ContainerBound(dataSize, blockSize, BlockBound(0));
+	}
+
+	std::unique_ptr<Core::EncoderContext> LZ77Compression::createEncoder() const
+	{
+		return std::make_unique<LZ77Encoder>(blockSize, threadCount, windowLog, searchDepth);
+	}
+
+	std::unique_ptr<Core::DecoderContext> LZ77Compression::createDecoder() const
+	{
+		return std::make_unique<LZ77Decoder>(threadCount);
+	}
+
+	void LZ77Compression::decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const
+	{
+		if (dataToDecode.empty() || static_cast<std::uint8_t>(dataToDecode[0]) != (Huffman::kFormatMarker | kContainerVersion))
+		{
+			Core::CompressionMethod::decodeRange(dataToDecode, offset, length, data);
+			return;
+		}
+
+		Core::BlockIndex index = Core::ReadBlockIndex(dataToDecode.data(), dataToDecode.size());
+		if (index.flags != 0) throw Core::CompressionException("Unsupported format flags");
+
+		offset = std::min(offset, index.originalSize);
+		length = std::min(length, index.originalSize - offset);
+
+		std::size_t outputOffset = data.size();
+		data.resize(outputOffset + length);
+		Core::DecodeBlocks(dataToDecode.data(), index, offset, length, data.data() + outputOffset, threadCount, DecodeBlock);
+	}
+
+	void LZ77Compression::encodeStream(std::istream& input, std::ostream& output) const
+	{
+		Core::EncodeBlockStream(Huffman::kFormatMarker | kContainerVersion, Huffman::kFormatMarker | kFormatVersion, 0, input, output,
+			blockSize, threadCount, memoryBudget, blockEncoder());
+	}
+
+	void LZ77Compression::decodeStream(std::istream& input, std::ostream& output) const
+	{
+		int first = input.peek();
+		if (first != (Huffman::kFormatMarker | kContainerVersion))
+		{
+			std::vector<char> dataToDecode;
+			char buffer[1 << 16];
+			while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0)
+			{
+				dataToDecode.insert(dataToDecode.end(), buffer, buffer + input.gcount());
+			}
+
+			std::vector<char> data;
+			decode(dataToDecode, data);
+			output.write(data.data(), data.size());
+		}
+		else
+		{
+			input.get();
+			if (input.get() != 0) throw Core::CompressionException("Unsupported format flags");
+
+			Core::DecodeBlockStream(input, output, threadCount, memoryBudget, BlockBound(0), DecodeBlock);
+		}
+
+		if (!output) throw Core::CompressionException("Error writing output");
+	}
+
+	void LZ77Compression::encodeStream(std::span<const char> input, std::ostream& output) const
+	{
+		Core::EncodeBlockStream(Huffman::kFormatMarker | kContainerVersion, Huffman::kFormatMarker | kFormatVersion, 0, input, output,
+			blockSize, threadCount, memoryBudget, blockEncoder());
+	}
+
+	void LZ77Compression::decodeStream(std::span<const char> input, std::ostream& output) const
+	{
+		if (input.empty() || static_cast<std::uint8_t>(input[0]) != (Huffman::kFormatMarker | kContainerVersion))
+		{
+			std::vector<char> data;
+			decode(input, data);
+			output.write(data.data(), data.size());
+		}
+		else
+		{
+			Core::BlockIndex index = Core::ReadBlockIndex(input.data(), input.size());
+			if (index.flags != 0) throw Core::CompressionException("Unsupported format flags");
+
+			Core::DecodeBlockStream(input.data(), index, output, threadCount, memoryBudget, DecodeBlock);
+		}
+
+		if (!output) throw Core::CompressionException("Error writing output");
+	}
+
+	Core::BlockEncoder LZ77Compression::blockEncoder() const
+	{
+		return [windowLog = windowLog, searchDepth = searchDepth](const char* data, std::size_t size, std::vector<char>& encodedBlock)
+		{
+			EncodeBlock(data, size, encodedBlock, windowLog, searchDepth);
+		};
+	}
+}
@@ -0,0 +1,388 @@
+#pragma once
+
+#include "Core.h"
+#include "BitStream.h"
+#include "BlockContainer.h"
+#include "Huffman.h"
+
+namespace LZ77
+{
+	/**
+	* @brief Version of the single-block LZ77 stream, the first byte is Huffman::kFormatMarker | kFormatVersion.
+	*
+	* The stream format:
+	* - 8 bits: Huffman::kFormatMarker | kFormatVersion
+	* - 8 bits: flags, reserved (0)
+	* - A block written by LZ77Encoder::encodeBlock
+	*/
+	constexpr std::uint8_t kFormatVersion = 4;
+
+	/**
+	* @brief Version of the LZ77 block container, see Core::EncodeBlocks.
+	*/
+	constexpr std::uint8_t kContainerVersion = 5;
+
+	/**
+	* @brief Shortest match worth coding.
+	*/
+	constexpr std::size_t kMinMatch = 3;
+
+	/**
+	* @brief Longest match, the length code covers kMinMatch + 16 bits.
+	*/
+	constexpr std::size_t kMaxMatch = kMinMatch + 0xFFFF;
+
+	/**
+	* @brief Number of length codes following the 256 literals in the literal/length alphabet.
+	*/
+	constexpr std::size_t kLengthCodes = 32;
+
+	/**
+	* @brief Size of the literal/length alphabet.
+	*/
+	constexpr std::size_t kLiteralAlphabetSize = 256 + kLengthCodes;
+
+	/**
+	* @brief Smallest selectable window, as a power of two.
+	*/
+	constexpr int kMinWindowLog = 10;
+
+	/**
+	* @brief Largest selectable window, as a power of two.
+	*/
+	constexpr int kMaxWindowLog = 24;
+
+	/**
+	* @brief Default window, 1 MiB.
+	*/
+	constexpr int kDefaultWindowLog = 20;
+
+	/**
+	* @brief Size of the distance alphabet, two codes per power of two up to the largest window.
+	*/
+	constexpr std::size_t kDistanceAlphabetSize = 2 * kMaxWindowLog;
+
+	/**
+	* @brief Default number of hash chain candidates examined per position.
+	*/
+	constexpr unsigned kDefaultSearchDepth = 32;
+
+	/**
+	* @brief Block type byte: the block holds the input unchanged.
+	*/
+	constexpr std::uint8_t kStoredBlock = 0;
+
+	/**
+	* @brief Block type byte: the block holds Huffman coded literals and matches.
+	*/
+	constexpr std::uint8_t kCompressedBlock = 1;
+
+	/**
+	* @brief Returns the largest size of a block encoding dataSize bytes.
+	*
+	* Blocks that would not shrink are stored, so a block never exceeds its input by more than its header.
+	*/
+	constexpr std::size_t BlockBound(std::size_t dataSize) { return Core::kMaxVarintSize + 1 + dataSize; }
+
+	/**
+	* @brief Maps a length or distance value to its code, two codes per power of two.
+	*
+	* Values 0-3 have codes of their own, larger values are coded by their highest two bits
+	* and followed by the remaining bits as extra bits.
+	*
+	* @param value The value to code.
+	* @param extraBits Reference to store the number of extra bits.
+	* @return The code.
+	*/
+	inline std::uint32_t BucketCode(std::uint32_t value, int& extraBits)
+	{
+		if (value < 4)
+		{
+			extraBits = 0;
+			return value;
+		}
+
+		int log = std::bit_width(value) - 1;
+		extraBits = log - 1;
+		return 2 * log + ((value >> (log - 1)) & 1);
+	}
+
+	/**
+	* @brief Returns the smallest value of a code and stores its number of extra bits.
+	*/
+	inline std::uint32_t BucketBase(std::uint32_t code, int& extraBits)
+	{
+		if (code < 4)
+		{
+			extraBits = 0;
+			return code;
+		}
+
+		extraBits = static_cast<int>(code >> 1) - 1;
+		return (2 | (code & 1)) << extraBits;
+	}
+
+	/**
+	* @brief A literal or a match found by the match finder.
+	*/
+	struct Token
+	{
+		/**< Match length, 0 for a literal. */
+		std::uint32_t length;
+
+		/**< Match distance, or the literal byte. */
+		std::uint32_t value;
+	};
+
+	/**
+	* @brief Encodes one block through a temporary LZ77Encoder, see LZ77Encoder::encodeBlock.
+	*
+	* @throw Core::CompressionException if there is an error during encoding.
+	*/
+	void EncodeBlock(const char* data, std::size_t dataSize, std::vector<char>& encodedBlock, int windowLog, unsigned searchDepth);
+
+	/**
+	* @brief Decodes one block through a temporary LZ77Decoder, see LZ77Decoder::decodeBlock.
+	*
+	* @throw Core::CompressionException if the block is malformed.
+	*/
+	void DecodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize);
+
+	/**
+	* @brief Reusable LZ77 encoder keeping its match finder, token buffer and code tables between calls.
+	*/
+	class LZ77Encoder : public Core::EncoderContext
+	{
+	public:
+		/**
+		* @brief Constructs the encoder.
+		*
+		* @param blockSize Amount of input per independently encoded block.
+		* @param threadCount Number of threads encoding the blocks of large inputs.
+		* @param windowLog Largest match distance as a power of two, clamped to [kMinWindowLog, kMaxWindowLog].
+		* @param searchDepth Number of hash chain candidates examined per position.
+		*/
+		LZ77Encoder(std::size_t blockSize, unsigned threadCount, int windowLog = kDefaultWindowLog, unsigned searchDepth = kDefaultSearchDepth);
+
+		/**
+		* @brief Encodes data into a caller-provided buffer.
+		*
+		* Inputs fitting in one block are written as a single-block stream, larger inputs are
+		* split into blocks encoded on threadCount threads and framed into a block container.
+		*
+		* @throw Core::CompressionException if the buffer is too small or there is an error during encoding.
+		*/
+		std::size_t encode(std::span<const std::byte> data, std::span<std::byte> encodedData) override;
+
+		/**
+		* @brief Encodes one block.
+		*
+		* Matches are found with hash chains over the window and one step of lazy evaluation,
+		* then literals and match lengths share one Huffman code and distances use another.
+		*
+		* The block format:
+		* - varint: size of the original data
+		* - 8 bits: kStoredBlock or kCompressedBlock
+		* - kStoredBlock: the original data
+		* - kCompressedBlock:
+		*   - code lengths of the literal/length alphabet, see Huffman::WriteCodeLengths
+		*   - code lengths of the distance alphabet
+		*   - per token: literal/length code, for matches followed by the length extra bits,
+		*     the distance code and the distance extra bits
+		*
+		* @param data Pointer to the data to be encoded.
+		* @param dataSize The size of the data.
+		* @param encodedBlock Buffer receiving the encoded block, BlockBound(dataSize) bytes always suffice.
+		* @param capacity The size of the buffer.
+		* @return The size of the encoded block.
+		*
+		* @throw Core::CompressionException if the buffer is too small.
+		*/
+		std::size_t encodeBlock(const char* data, std::size_t dataSize, char* encodedBlock, std::size_t capacity);
+
+	private:
+		/**
+		* @brief Fills the token buffer and the symbol counts with the parse of a block.
+		*/
+		void findTokens(const std::uint8_t* data, std::size_t size);
+
+		/**
+		* @brief Finds the longest match for position on the hash chain, returns its length (0 if none).
+		*/
+		std::size_t findMatch(const std::uint8_t* data, std::size_t size, std::size_t position, std::size_t& distance) const;
+
+		/**
+		* @brief Links position into the hash chains.
+		*/
+		void insert(const std::uint8_t* data, std::size_t position);
+
+		std::size_t blockSize;
+
+		unsigned threadCount;
+
+		int windowLog;
+
+		unsigned searchDepth;
+
+		/**< Most recent stored position per hash. Stored positions are offset by positionBase, so
+		     entries left by earlier blocks read as empty without clearing the table. */
+		std::vector<std::uint32_t> head;
+
+		/**< Previous stored position with the same hash, per position in the window. */
+		std::vector<std::uint32_t> chain;
+
+		std::uint32_t positionBase = 0;
+
+		std::vector<Token> tokens;
+
+		std::uint64_t extraBitCount = 0;
+
+		std::uint64_t literalCounts[kLiteralAlphabetSize];
+
+		std::uint64_t distanceCounts[kDistanceAlphabetSize];
+
+		std::uint8_t literalLengths[kLiteralAlphabetSize];
+
+		std::uint8_t distanceLengths[kDistanceAlphabetSize];
+
+		Huffman::EncodeEntry literalTable[kLiteralAlphabetSize];
+
+		Huffman::EncodeEntry distanceTable[kDistanceAlphabetSize];
+
+		std::vector<char> scratch;
+	};
+
+	/**
+	* @brief Reusable LZ77 decoder keeping its decode tables between calls.
+	*/
+	class LZ77Decoder : public Core::DecoderContext
+	{
+	public:
+		/**
+		* @brief Constructs the decoder.
+		*
+		* @param threadCount Number of threads decoding blocks of block containers concurrently.
+		*/
+		explicit LZ77Decoder(unsigned threadCount);
+
+		/**
+		* @brief Returns the decoded size stored in the stream header.
+		*
+		* @throw Core::CompressionException if the data format is invalid.
+		*/
+		std::size_t decodedSize(std::span<const std::byte> encodedData) override;
+
+		/**
+		* @brief Decodes data into a caller-provided buffer.
+		*
+		* @throw Core::CompressionException if the buffer is too small or there is an error during decoding.
+		*/
+		std::size_t decode(std::span<const std::byte> encodedData, std::span<std::byte> data) override;
+
+		/**
+		* @brief Decodes one block written by LZ77Encoder::encodeBlock.
+		*
+		* @param block Pointer to the encoded block.
+		* @param blockSize The size of the encoded block.
+		* @param output Pointer to the buffer receiving the decoded data.
+		* @param outputSize The number of bytes the block must decode to.
+		*
+		* @throw Core::CompressionException if the block is malformed.
+		*/
+		void decodeBlock(const char* block, std::size_t blockSize, char* output, std::size_t outputSize);
+
+	private:
+		unsigned threadCount;
+
+		Huffman::DecodeTable literalTable;
+
+		Huffman::DecodeTable distanceTable;
+	};
+
+	/**
+	* @brief A class containing the LZ77 compression method: hash chain match finding with Huffman coded literals, lengths and distances.
+	*/
+	class LZ77Compression : public Core::CompressionMethod, public Core::StreamCompressionMethod
+	{
+	public:
+		/**
+		* @brief Constructs the method.
+		*
+		* @param blockSize Amount of input per independently encoded block, matches do not cross blocks.
+		* @param threadCount Number of threads encoding and decoding blocks concurrently.
+		* @param memoryBudget Bytes the streaming encoder and decoder may use for blocks in flight.
+		* @param windowLog Largest match distance as a power of two, clamped to [kMinWindowLog, kMaxWindowLog].
+		* @param searchDepth Number of hash chain candidates examined per position, more is slower and smaller.
+		*/
+		explicit LZ77Compression(std::size_t blockSize = Core::kDefaultBlockSize, unsigned threadCount = 1, std::size_t memoryBudget = Core::kDefaultMemoryBudget,
+			int windowLog = kDefaultWindowLog, unsigned searchDepth = kDefaultSearchDepth);
+
+		/**
+		* @brief Returns the largest encoded size of dataSize bytes, including the bit writer's slack.
+		*/
+		std::size_t compressBound(std::size_t dataSize) const override;
+
+		/**
+		* @brief Creates an LZ77Encoder with this method's parameters.
+		*/
+		std::unique_ptr<Core::EncoderContext> createEncoder() const override;
+
+		/**
+		* @brief Creates an LZ77Decoder with this method's thread count.
+		*/
+		std::unique_ptr<Core::DecoderContext> createDecoder() const override;
+
+		/**
+		* @brief Decodes only the bytes [offset, offset + length) of the original data.
+		*
+		* For block containers only the blocks covering the range are decoded, on threadCount threads.
+		*
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeRange(std::span<const char> dataToDecode, std::size_t offset, std::size_t length, std::vector<char>& data) const override;
+
+		/**
+		* @brief Encodes a stream in blocks, keeping at most memoryBudget bytes of blocks in flight.
+		*
+		* @throw Core::CompressionException if there is an error during encoding.
+		*/
+		void encodeStream(std::istream& input, std::ostream& output) const override;
+
+		/**
+		* @brief Decodes a stream written by encode or encodeStream.
+		*
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeStream(std::istream& input, std::ostream& output) const override;
+
+		/**
+		* @brief Encodes an input already in memory, block by block straight from the input view.
+		*
+		* @throw Core::CompressionException if there is an error during encoding.
+		*/
+		void encodeStream(std::span<const char> input, std::ostream& output) const override;
+
+		/**
+		* @brief Decodes an input already in memory, block containers in ranges bounded by memoryBudget.
+		*
+		* @throw Core::CompressionException if there is an error during decoding.
+		*/
+		void decodeStream(std::span<const char> input, std::ostream& output) const override;
+
+	private:
+		/**
+		* @brief Returns the block encoder used by the container and stream paths.
+		*/
+		Core::BlockEncoder blockEncoder() const;
+
+		std::size_t blockSize;
+
+		unsigned threadCount;
+
+		std::size_t memoryBudget;
+
+		int windowLog;
+
+		unsigned searchDepth;
+	};
+}
@@ -0,0 +1,119 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Core
+{
+#ifdef _WIN32
+	MappedFile::MappedFile(const String& filepath, AccessHint hint)
+	{
+		DWORD flags = hint == AccessHint::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+		if (file == INVALID_HANDLE_VALUE) throw CompressionException("Error loading: " + filepath);
+
+		LARGE_INTEGER fileSize;
+		if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &fileSize))
+		{
+			CloseHandle(file);
+			readBuffered(filepath);
+			return;
+		}
+
+		length = static_cast<std::size_t>(fileSize.QuadPart);
+		if (length == 0)
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (!view)
+		{
+			if (mapping) CloseHandle(mapping);
+			CloseHandle(file);
+			readBuffered(filepath);
+			return;
+		}
+
+		fileHandle = file;
+		mappingHandle = mapping;
+		contents = static_cast<const char*>(view);
+		mapped = true;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (mapped)
+		{
+			UnmapViewOfFile(contents);
+			CloseHandle(static_cast<HANDLE>(mappingHandle));
+			CloseHandle(static_cast<HANDLE>(fileHandle));
+		}
+	}
+#else
+	MappedFile::MappedFile(const String& filepath, AccessHint hint)
+	{
+		int descriptor = open(filepath.c_str(), O_RDONLY);
+		if (descriptor < 0) throw CompressionException("Error loading: " + filepath);
+
+		struct stat status;
+		if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode))
+		{
+			close(descriptor);
+			readBuffered(filepath);
+			return;
+		}
+
+		length = static_cast<std::size_t>(status.st_size);
+		if (length == 0)
+		{
+			close(descriptor);
+			return;
+		}
+
+		void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		close(descriptor);
+		if (view == MAP_FAILED)
+		{
+			readBuffered(filepath);
+			return;
+		}
+
+		madvise(view, length, hint == AccessHint::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+		contents = static_cast<const char*>(view);
+		mapped = true;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		if (mapped) munmap(const_cast<char*>(contents), length);
+	}
+#endif
+
+	void MappedFile::readBuffered(const String& filepath)
+	{
+		std::ifstream file(filepath, std::ios::binary);
+		if (!file) throw CompressionException("Error loading: " + filepath);
+
+		buffer.clear();
+		char chunk[1 << 16];
+		while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0)
+		{
+			buffer.insert(buffer.end(), chunk, chunk + file.gcount());
+		}
+		if (file.bad()) throw CompressionException("Error loading: " + filepath);
+
+		contents = buffer.empty() ? nullptr : buffer.data();
+		length = buffer.size();
+		mapped = false;
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Core.h"
+#include <span>
+
+namespace Core
+{
+	/**
+	* @brief Expected access pattern of a mapped file, passed to the kernel as a paging hint.
+	*/
+	enum class AccessHint
+	{
+		Sequential,
+		Random
+	};
+
+	/**
+	* @brief A read-only view of a whole file, memory-mapped when possible.
+	*
+	* Regular files are mapped into memory, so the data is read straight from the page cache
+	* without a copy into a heap buffer. Pipes, special files and files that cannot be mapped
+	* are read into an owned buffer instead.
+	*/
+	class MappedFile
+	{
+	public:
+		/**
+		* @brief Maps or reads the file.
+		*
+		* @param filepath The path to the file.
+		* @param hint Expected access pattern of the mapping.
+		*
+		* @throw CompressionException if the file cannot be opened or read.
+		*/
+		explicit MappedFile(const String& filepath, AccessHint hint = AccessHint::Sequential);
+
+		MappedFile(const MappedFile&) = delete;
+
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		* @brief Unmaps the file.
+		*/
+		~MappedFile();
+
+		/**
+		* @brief Returns a pointer to the file contents, nullptr for empty files.
+		*/
+		const char* data() const { return contents; }
+
+		/**
+		* @brief Returns the size of the file.
+		*/
+		std::size_t size() const { return length; }
+
+		/**
+		* @brief Returns the file contents as a byte view.
+		*/
+		std::span<const char> view() const { return { contents, length }; }
+
+		/**
+		* @brief Returns true if the contents are memory-mapped rather than read into a buffer.
+		*/
+		bool isMapped() const { return mapped; }
+
+	private:
+		/**
+		* @brief Reads the file through buffered reads into the owned buffer.
+		*/
+		void readBuffered(const String& filepath);
+
+		const char* contents = nullptr;
+
+		std::size_t length = 0;
+
+		bool mapped = false;
+
+		std::vector<char> buffer;
+
+#ifdef _WIN32
+		void* fileHandle = nullptr;
+
+		void* mappingHandle = nullptr;
+#endif
+	};
+}
@@ -0,0 +1,109 @@
+#include "Pipeline.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+	void RunPipeline(std::size_t slotCount, unsigned workerCount, const PipelineSource& read, const PipelineStage& process, const PipelineStage& write)
+	{
+		slotCount = std::max<std::size_t>(slotCount, 1);
+		workerCount = std::max(workerCount, 1u);
+
+		BoundedQueue<std::size_t> freeSlots(slotCount);
+		BoundedQueue<std::size_t> readSlots(slotCount);
+		BoundedQueue<std::size_t> orderedSlots(slotCount);
+		for (std::size_t slot = 0; slot < slotCount; slot++) freeSlots.push(slot);
+
+		std::mutex mutex;
+		std::condition_variable slotProcessed;
+		std::vector<bool> processed(slotCount, false);
+		std::exception_ptr firstError;
+
+		auto fail = [&]
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!firstError) firstError = std::current_exception();
+				slotProcessed.notify_all();
+			}
+			freeSlots.cancel();
+			readSlots.cancel();
+			orderedSlots.cancel();
+		};
+
+		std::thread reader([&]
+		{
+			try
+			{
+				std::size_t slot;
+				while (freeSlots.pop(slot) && read(slot))
+				{
+					orderedSlots.push(slot);
+					readSlots.push(slot);
+				}
+				readSlots.close();
+				orderedSlots.close();
+			}
+			catch (...)
+			{
+				fail();
+			}
+		});
+
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (unsigned worker = 0; worker < workerCount; worker++)
+		{
+			workers.emplace_back([&]
+			{
+				try
+				{
+					std::size_t slot;
+					while (readSlots.pop(slot))
+					{
+						process(slot);
+
+						std::lock_guard<std::mutex> lock(mutex);
+						processed[slot] = true;
+						slotProcessed.notify_all();
+					}
+				}
+				catch (...)
+				{
+					fail();
+				}
+			});
+		}
+
+		try
+		{
+			std::size_t slot;
+			while (orderedSlots.pop(slot))
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					slotProcessed.wait(lock, [&] { return processed[slot] || firstError; });
+					if (firstError) break;
+					processed[slot] = false;
+				}
+
+				write(slot);
+				freeSlots.push(slot);
+			}
+		}
+		catch (...)
+		{
+			fail();
+		}
+
+		// Once the reader stops, the free slots are no longer waited on.
+		reader.join();
+		freeSlots.cancel();
+		for (std::thread& worker : workers) worker.join();
+
+		if (firstError) std::rethrow_exception(firstError);
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace Core
+{
+	/**
+	* @brief A queue of at most a fixed number of items, shared by producer and consumer threads.
+	*
+	* Every operation holds the lock only to move one item, the threads of a pipeline spend
+	* their time in their stages, not on the queue.
+	*/
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		/**
+		* @brief Creates an empty queue holding up to capacity items (at least one).
+		*/
+		explicit BoundedQueue(std::size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {}
+
+		BoundedQueue(const BoundedQueue&) = delete;
+
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+		/**
+		* @brief Appends an item, waiting while the queue is full.
+		*
+		* @return false if the queue was closed or cancelled, the item is then dropped.
+		*/
+		bool push(T item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notFull.wait(lock, [this] { return closed || items.size() < capacity; });
+			if (closed) return false;
+
+			items.push_back(std::move(item));
+			notEmpty.notify_one();
+			return true;
+		}
+
+		/**
+		* @brief Removes the oldest item, waiting while the queue is empty and open.
+		*
+		* @return false once the queue is closed and drained, or cancelled.
+		*/
+		bool pop(T& item)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [this] { return closed || !items.empty(); });
+			if (items.empty() || cancelled) return false;
+
+			item = std::move(items.front());
+			items.pop_front();
+			notFull.notify_one();
+			return true;
+		}
+
+		/**
+		* @brief Ends the input, consumers still receive the queued items.
+		*/
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+			notEmpty.notify_all();
+			notFull.notify_all();
+		}
+
+		/**
+		* @brief Ends the queue at once, dropping the queued items.
+		*/
+		void cancel()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+			cancelled = true;
+			notEmpty.notify_all();
+			notFull.notify_all();
+		}
+
+	private:
+		std::size_t capacity;
+
+		std::deque<T> items;
+
+		std::mutex mutex;
+
+		std::condition_variable notEmpty;
+
+		std::condition_variable notFull;
+
+		bool closed = false;
+
+		bool cancelled = false;
+	};
+
+	/**
+	* @brief A stage of RunPipeline, working on the buffers of one slot.
+	*/
+	using PipelineStage = std::function<void(std::size_t slot)>;
+
+	/**
+	* @brief Fills the buffers of a slot with the next item, returns false at the end of the input.
+	*/
+	using PipelineSource = std::function<bool(std::size_t slot)>;
+
+	/**
+	* @brief Runs a read, process and write pipeline over a sequence of items.
+	*
+	* A reader thread fills free slots with items, workerCount threads process them in any
+	* order and the calling thread writes them in the order they were read, then returns the
+	* slot to the reader. The stages overlap, so the job takes about as long as its slowest
+	* stage rather than the sum of all three. Memory stays bounded by the slots, which the
+	* caller owns: each stage only touches the buffers of the slot it is given. The first
+	* slotCount items are read into slots 0, 1, ... in order.
+	*
+	* @param slotCount Number of items in flight, at least one.
+	* @param workerCount Number of threads processing items, at least one.
+	* @param read Reads the next item into a slot, called on the reader thread.
+	* @param process Processes the item of a slot, called on the worker threads.
+	* @param write Writes the item of a slot, called on the calling thread.
+	*
+	* @throw The first exception thrown by a stage, after every thread has stopped.
+	*/
+	void RunPipeline(std::size_t slotCount, unsigned workerCount, const PipelineSource& read, const PipelineStage& process, const PipelineStage& write);
+}
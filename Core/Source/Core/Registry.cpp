@@ -0,0 +1,190 @@
+#include "Registry.h"
+#include "Huffman.h"
+#include "LZ77.h"
+#include "ANS.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace Core
+{
+	static constexpr std::uint8_t kHuffmanId = 1;
+
+	static constexpr std::uint8_t kLZ77Id = 2;
+
+	static constexpr std::uint8_t kANSId = 3;
+
+	static_assert(SingleBlockMarker(kHuffmanId) == (Huffman::kFormatMarker | Huffman::kFormatVersion));
+	static_assert(ContainerMarker(kHuffmanId) == (Huffman::kFormatMarker | Huffman::kContainerVersion));
+	static_assert(SingleBlockMarker(kLZ77Id) == (Huffman::kFormatMarker | LZ77::kFormatVersion));
+	static_assert(ContainerMarker(kLZ77Id) == (Huffman::kFormatMarker | LZ77::kContainerVersion));
+	static_assert(SingleBlockMarker(kANSId) == (Huffman::kFormatMarker | ANS::kFormatVersion));
+	static_assert(ContainerMarker(kANSId) == (Huffman::kFormatMarker | ANS::kContainerVersion));
+
+	static std::vector<MethodInfo> BuiltInMethods()
+	{
+		constexpr std::uint32_t kCommon = kStreamingCapability | kRangeDecodeCapability | kAutoCandidateCapability;
+
+		return {
+			{ "huf", kHuffmanId, kCommon, "canonical Huffman coding of bytes",
+				[](const MethodOptions& options) -> std::unique_ptr<CompressionMethod>
+				{
+					return std::make_unique<Huffman::HuffmanCompression>(options.blockSize, options.threadCount, options.memoryBudget,
+						options.maxCodeLength ? options.maxCodeLength : Huffman::kDefaultCodeLengthLimit, true, options.sharedTable);
+				} },
+			{ "lz77", kLZ77Id, kCommon | kMatchFindingCapability, "repeated strings and Huffman coding, like deflate",
+				[](const MethodOptions& options) -> std::unique_ptr<CompressionMethod>
+				{
+					return std::make_unique<LZ77::LZ77Compression>(options.blockSize, options.threadCount, options.memoryBudget,
+						options.windowLog ? options.windowLog : LZ77::kDefaultWindowLog, options.searchDepth ? options.searchDepth : LZ77::kDefaultSearchDepth);
+				} },
+			{ "ans", kANSId, kCommon, "table-based asymmetric numeral system coding of bytes",
+				[](const MethodOptions& options) -> std::unique_ptr<CompressionMethod>
+				{
+					return std::make_unique<ANS::ANSCompression>(options.blockSize, options.threadCount, options.memoryBudget,
+						options.maxTableLog ? options.maxTableLog : ANS::kDefaultTableLog);
+				} },
+		};
+	}
+
+	static std::vector<MethodInfo>& Registry()
+	{
+		static std::vector<MethodInfo> methods = BuiltInMethods();
+		return methods;
+	}
+
+	void RegisterMethod(MethodInfo method)
+	{
+		if (method.id == 0 || method.id > MethodId(0xFF)) throw CompressionException("Invalid method id");
+		if (FindMethod(method.name) || FindMethod(method.id)) throw CompressionException("Method already registered: " + method.name);
+
+		Registry().push_back(std::move(method));
+	}
+
+	const std::vector<MethodInfo>& RegisteredMethods()
+	{
+		return Registry();
+	}
+
+	const MethodInfo* FindMethod(const String& name)
+	{
+		for (const MethodInfo& method : Registry())
+		{
+			if (method.name == name) return &method;
+		}
+		return nullptr;
+	}
+
+	const MethodInfo* FindMethod(std::uint8_t id)
+	{
+		for (const MethodInfo& method : Registry())
+		{
+			if (method.id == id) return &method;
+		}
+		return nullptr;
+	}
+
+	const MethodInfo& DetectMethod(std::uint8_t firstByte)
+	{
+		std::uint8_t id = firstByte & Huffman::kFormatMarker ? MethodId(firstByte) : kHuffmanId;
+
+		const MethodInfo* method = FindMethod(id);
+		if (!method) throw CompressionException("Unsupported format version");
+		return *method;
+	}
+
+	/**
+	* @brief Returns the CPU time used by the calling thread, in seconds.
+	*
+	* Unlike wall-clock time it does not grow while other threads hold the cores.
+	*/
+	static double ThreadCpuSeconds()
+	{
+#ifdef _WIN32
+		FILETIME creation, exit, kernel, user;
+		GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+		auto ticks = [](FILETIME time) { return (std::uint64_t(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+		return static_cast<double>(ticks(kernel) + ticks(user)) * 1e-7;
+#else
+		timespec time;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+		return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+	}
+
+	const MethodInfo& SelectMethod(std::span<const char> data, const MethodOptions& options, double minEncodeSpeed)
+	{
+		std::vector<const MethodInfo*> candidates;
+		for (const MethodInfo& method : Registry())
+		{
+			if (method.capabilities & kAutoCandidateCapability) candidates.push_back(&method);
+		}
+		if (candidates.empty()) throw CompressionException("No compression method to choose from");
+		if (data.empty()) return *candidates.front();
+
+		std::vector<std::span<const char>> samples;
+		if (data.size() <= kSelectionSampleBudget)
+		{
+			samples.push_back(data);
+		}
+		else
+		{
+			std::size_t sampleSize = std::clamp<std::size_t>(options.blockSize, 1, kSelectionSampleBudget);
+			std::size_t sampleCount = kSelectionSampleBudget / sampleSize;
+			std::size_t stride = sampleCount > 1 ? (data.size() - sampleSize) / (sampleCount - 1) : 0;
+			std::size_t first = sampleCount > 1 ? 0 : (data.size() - sampleSize) / 2;
+			for (std::size_t sample = 0; sample < sampleCount; sample++)
+			{
+				samples.push_back(data.subspan(first + sample * stride, sampleSize));
+			}
+		}
+
+		MethodOptions sampleOptions = options;
+		sampleOptions.threadCount = 1;
+
+		// Shorter samples encode within the timer's resolution, their speed is not measured.
+		std::size_t sampleSize = 0;
+		for (std::span<const char> sample : samples) sampleSize += sample.size();
+		bool timed = minEncodeSpeed > 0 && sampleSize >= kMinSelectionTimingSize;
+
+		const MethodInfo* smallest = nullptr;
+		const MethodInfo* fastest = nullptr;
+		std::size_t smallestSize = SIZE_MAX;
+		double fastestSeconds = 0;
+
+		std::vector<std::byte> encoded;
+		for (const MethodInfo* method : candidates)
+		{
+			std::unique_ptr<CompressionMethod> compressionMethod = method->create(sampleOptions);
+			std::unique_ptr<EncoderContext> encoder = compressionMethod->createEncoder();
+
+			std::size_t encodedSize = 0;
+			double start = ThreadCpuSeconds();
+			for (std::span<const char> sample : samples)
+			{
+				encoded.resize(compressionMethod->compressBound(sample.size()));
+				encodedSize += encoder->encode(std::as_bytes(sample), encoded);
+			}
+			double seconds = ThreadCpuSeconds() - start;
+
+			if (!fastest || seconds < fastestSeconds)
+			{
+				fastest = method;
+				fastestSeconds = seconds;
+			}
+
+			bool fastEnough = !timed || sampleSize / std::max(seconds, 1e-9) / 1e6 >= minEncodeSpeed;
+			if (fastEnough && encodedSize < smallestSize)
+			{
+				smallest = method;
+				smallestSize = encodedSize;
+			}
+		}
+
+		return smallest ? *smallest : *fastest;
+	}
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Core.h"
+#include "BlockContainer.h"
+#include <functional>
+#include <span>
+
+namespace Huffman
+{
+	class SharedTable;
+}
+
+namespace Core
+{
+	/**
+	* @brief Capability bit of methods implementing StreamCompressionMethod.
+	*/
+	constexpr std::uint32_t kStreamingCapability = 0x01;
+
+	/**
+	* @brief Capability bit of methods decoding a byte range without decoding the whole input.
+	*/
+	constexpr std::uint32_t kRangeDecodeCapability = 0x02;
+
+	/**
+	* @brief Capability bit of methods exploiting repeated strings, not only byte frequencies.
+	*/
+	constexpr std::uint32_t kMatchFindingCapability = 0x04;
+
+	/**
+	* @brief Capability bit of methods -m auto may choose.
+	*/
+	constexpr std::uint32_t kAutoCandidateCapability = 0x08;
+
+	/**
+	* @brief Bytes of input SelectMethod encodes with every candidate.
+	*/
+	constexpr std::size_t kSelectionSampleBudget = std::size_t(1) << 20;
+
+	/**
+	* @brief Smallest sample whose encoding speed SelectMethod measures.
+	*/
+	constexpr std::size_t kMinSelectionTimingSize = std::size_t(256) << 10;
+
+	/**
+	* @brief Default slowest encoding SelectMethod accepts, in MB/s.
+	*/
+	constexpr double kDefaultMinEncodeSpeed = 10.0;
+
+	/**
+	* @brief Returns the method id stored in the first byte of a versioned stream.
+	*
+	* Every method owns two consecutive versions, an even one for single-block streams and
+	* an odd one for block containers, so the first byte of any stream names its method.
+	*/
+	constexpr std::uint8_t MethodId(std::uint8_t marker) { return static_cast<std::uint8_t>((marker & 0x7F) >> 1); }
+
+	/**
+	* @brief Returns the first byte of a single-block stream of a method.
+	*/
+	constexpr std::uint8_t SingleBlockMarker(std::uint8_t id) { return static_cast<std::uint8_t>(0x80 | (id << 1)); }
+
+	/**
+	* @brief Returns the first byte of a block container of a method.
+	*/
+	constexpr std::uint8_t ContainerMarker(std::uint8_t id) { return static_cast<std::uint8_t>(0x80 | (id << 1) | 1); }
+
+	/**
+	* @brief Parameters of a job, each method takes the ones it understands.
+	*
+	* Method-specific parameters left at 0 select the method's default.
+	*/
+	struct MethodOptions
+	{
+		std::size_t blockSize = kDefaultBlockSize;
+
+		unsigned threadCount = 1;
+
+		std::size_t memoryBudget = kDefaultMemoryBudget;
+
+		/**< Longest Huffman code, used by huf. */
+		int maxCodeLength = 0;
+
+		/**< Window size as a power of two, used by lz77. */
+		int windowLog = 0;
+
+		/**< Match candidates searched per position, used by lz77. */
+		unsigned searchDepth = 0;
+
+		/**< Largest state table as a power of two, used by ans. */
+		int maxTableLog = 0;
+
+		/**< Trained code for small blocks, used by huf, see Huffman::TrainSharedTable. */
+		std::shared_ptr<const Huffman::SharedTable> sharedTable;
+	};
+
+	/**
+	* @brief A registered compression method.
+	*/
+	struct MethodInfo
+	{
+		/**< Name selecting the method with -m. */
+		String name;
+
+		/**< Id stored in the first byte of every stream of the method, see MethodId. */
+		std::uint8_t id;
+
+		/**< Bitwise or of the k...Capability constants. */
+		std::uint32_t capabilities;
+
+		/**< One-line description for help texts. */
+		String description;
+
+		/**< Constructs the method. */
+		std::function<std::unique_ptr<CompressionMethod>(const MethodOptions&)> create;
+	};
+
+	/**
+	* @brief Adds a method to the registry.
+	*
+	* The built-in methods are registered before the first lookup. Registering is not
+	* synchronized with lookups, methods should be registered at startup.
+	*
+	* @throw CompressionException if the name or id is already taken or the id does not fit in a marker.
+	*/
+	void RegisterMethod(MethodInfo method);
+
+	/**
+	* @brief Returns the registered methods in registration order, the built-in ones first.
+	*/
+	const std::vector<MethodInfo>& RegisteredMethods();
+
+	/**
+	* @brief Returns the method registered under a name, or nullptr.
+	*/
+	const MethodInfo* FindMethod(const String& name);
+
+	/**
+	* @brief Returns the method registered under an id, or nullptr.
+	*/
+	const MethodInfo* FindMethod(std::uint8_t id);
+
+	/**
+	* @brief Returns the method that wrote a stream, from the stream's first byte.
+	*
+	* Legacy Huffman streams, whose first byte is below kFormatMarker, belong to huf.
+	*
+	* @throw CompressionException if no registered method owns the marker.
+	*/
+	const MethodInfo& DetectMethod(std::uint8_t firstByte);
+
+	/**
+	* @brief Picks the method for data by encoding samples with every auto candidate.
+	*
+	* Chunks of one block, spread evenly over the data, are encoded one by one on a single
+	* thread until kSelectionSampleBudget bytes are sampled. Whole blocks are sampled because
+	* the speed of match finding depends on the block size. Among the candidates encoding
+	* the samples at minEncodeSpeed MB/s or faster the smallest output wins, if none is fast
+	* enough the fastest candidate wins.
+	*
+	* The speed is measured in CPU time of the calling thread, so threads encoding other data
+	* at the same time do not slow the candidates down. Samples smaller than
+	* kMinSelectionTimingSize are not timed, the smallest output wins.
+	*
+	* @param data The data to be encoded, empty data selects the first candidate.
+	* @param options Parameters the candidates are constructed with.
+	* @param minEncodeSpeed Slowest acceptable encoding in MB/s, 0 picks the best ratio.
+	*/
+	const MethodInfo& SelectMethod(std::span<const char> data, const MethodOptions& options, double minEncodeSpeed = kDefaultMinEncodeSpeed);
+}
@@ -0,0 +1,229 @@
+#include "Stats.h"
+
+#include <iomanip>
+#include <map>
+#include <mutex>
+
+namespace Core
+{
+	namespace Detail
+	{
+		std::atomic<bool> statsEnabled{ false };
+	}
+
+	static constexpr std::size_t kPhaseCount = static_cast<std::size_t>(Phase::Count);
+
+	static constexpr std::size_t kCounterCount = static_cast<std::size_t>(Counter::Count);
+
+	static std::atomic<std::uint64_t> phaseNanoseconds[kPhaseCount];
+
+	static std::atomic<std::uint64_t> phaseCalls[kPhaseCount];
+
+	static std::atomic<std::uint64_t> counters[kCounterCount];
+
+	static std::mutex blocksMutex;
+
+	static std::vector<BlockRecord> blocks;
+
+	static std::atomic<unsigned> nextThread{ 0 };
+
+	static unsigned ThreadNumber()
+	{
+		thread_local unsigned number = nextThread.fetch_add(1, std::memory_order_relaxed);
+		return number;
+	}
+
+	void Detail::RecordPhase(Phase phase, std::chrono::steady_clock::duration duration)
+	{
+		std::size_t index = static_cast<std::size_t>(phase);
+		phaseNanoseconds[index].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed);
+		phaseCalls[index].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Detail::RecordCounter(Counter counter, std::uint64_t value)
+	{
+		counters[static_cast<std::size_t>(counter)].fetch_add(value, std::memory_order_relaxed);
+	}
+
+	void Detail::RecordMax(Counter counter, std::uint64_t value)
+	{
+		std::atomic<std::uint64_t>& target = counters[static_cast<std::size_t>(counter)];
+		std::uint64_t current = target.load(std::memory_order_relaxed);
+		while (current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+	}
+
+	void Detail::RecordBlock(std::chrono::steady_clock::duration duration, std::size_t inputSize, std::size_t outputSize)
+	{
+		BlockRecord record{ ThreadNumber(), std::chrono::duration<double>(duration).count(), inputSize, outputSize };
+
+		std::lock_guard<std::mutex> lock(blocksMutex);
+		blocks.push_back(record);
+	}
+
+	void EnableStats(bool enabled)
+	{
+		Detail::statsEnabled.store(kStatsCompiled && enabled, std::memory_order_relaxed);
+	}
+
+	void ResetStats()
+	{
+		for (std::size_t i = 0; i < kPhaseCount; i++)
+		{
+			phaseNanoseconds[i].store(0, std::memory_order_relaxed);
+			phaseCalls[i].store(0, std::memory_order_relaxed);
+		}
+		for (std::atomic<std::uint64_t>& counter : counters) counter.store(0, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(blocksMutex);
+		blocks.clear();
+	}
+
+	StatsReport CollectStats()
+	{
+		StatsReport report;
+		for (std::size_t i = 0; i < kPhaseCount; i++)
+		{
+			report.phaseSeconds[i] = phaseNanoseconds[i].load(std::memory_order_relaxed) / 1e9;
+			report.phaseCalls[i] = phaseCalls[i].load(std::memory_order_relaxed);
+		}
+		for (std::size_t i = 0; i < kCounterCount; i++) report.counters[i] = counters[i].load(std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(blocksMutex);
+		report.blocks = blocks;
+		return report;
+	}
+
+	const char* PhaseName(Phase phase)
+	{
+		switch (phase)
+		{
+			case Phase::ReadInput: return "read_input";
+			case Phase::Histogram: return "histogram";
+			case Phase::MatchFinding: return "match_finding";
+			case Phase::CodeLengths: return "code_lengths";
+			case Phase::Header: return "header";
+			case Phase::Packing: return "packing";
+			case Phase::Unpacking: return "unpacking";
+			case Phase::WriteOutput: return "write_output";
+			default: return "unknown";
+		}
+	}
+
+	const char* CounterName(Counter counter)
+	{
+		switch (counter)
+		{
+			case Counter::BytesIn: return "bytes_in";
+			case Counter::BytesOut: return "bytes_out";
+			case Counter::Symbols: return "symbols";
+			case Counter::CodedBits: return "coded_bits";
+			case Counter::MaxCodeLength: return "max_code_length";
+			case Counter::HeaderBytes: return "header_bytes";
+			case Counter::StoredBlocks: return "stored_blocks";
+			default: return "unknown";
+		}
+	}
+
+	static std::uint64_t CounterValue(const StatsReport& report, Counter counter)
+	{
+		return report.counters[static_cast<std::size_t>(counter)];
+	}
+
+	static double AverageCodeLength(const StatsReport& report)
+	{
+		std::uint64_t symbols = CounterValue(report, Counter::Symbols);
+		return symbols ? static_cast<double>(CounterValue(report, Counter::CodedBits)) / symbols : 0.0;
+	}
+
+	/**
+	* @brief Block totals of one thread.
+	*/
+	struct ThreadTotals
+	{
+		std::size_t blocks = 0;
+
+		double seconds = 0;
+
+		std::size_t inputSize = 0;
+	};
+
+	static std::map<unsigned, ThreadTotals> TotalsPerThread(const StatsReport& report)
+	{
+		std::map<unsigned, ThreadTotals> totals;
+		for (const BlockRecord& block : report.blocks)
+		{
+			ThreadTotals& thread = totals[block.thread];
+			thread.blocks++;
+			thread.seconds += block.seconds;
+			thread.inputSize += block.inputSize;
+		}
+		return totals;
+	}
+
+	void WriteStatsSummary(std::ostream& output, const StatsReport& report, double wallSeconds)
+	{
+		std::uint64_t bytesIn = CounterValue(report, Counter::BytesIn);
+		std::uint64_t bytesOut = CounterValue(report, Counter::BytesOut);
+
+		output << std::fixed << std::setprecision(3);
+		output << "bytes in:         " << bytesIn << std::endl;
+		output << "bytes out:        " << bytesOut;
+		if (bytesIn > 0) output << " (" << 100.0 * bytesOut / bytesIn << "%)";
+		output << std::endl;
+		output << "symbols:          " << CounterValue(report, Counter::Symbols) << std::endl;
+		output << "code length:      " << AverageCodeLength(report) << " bits average, " << CounterValue(report, Counter::MaxCodeLength) << " bits max" << std::endl;
+		output << "header bytes:     " << CounterValue(report, Counter::HeaderBytes) << std::endl;
+		output << "stored blocks:    " << CounterValue(report, Counter::StoredBlocks) << std::endl;
+		output << "wall time:        " << wallSeconds * 1e3 << " ms" << std::endl;
+
+		output << "phases (summed over threads):" << std::endl;
+		for (std::size_t i = 0; i < kPhaseCount; i++)
+		{
+			if (report.phaseCalls[i] == 0) continue;
+			output << "  " << std::left << std::setw(16) << PhaseName(static_cast<Phase>(i)) << std::right
+				<< std::setw(12) << report.phaseSeconds[i] * 1e3 << " ms " << std::setw(8) << report.phaseCalls[i] << " calls" << std::endl;
+		}
+
+		output << "blocks:           " << report.blocks.size() << std::endl;
+		for (const auto& [thread, totals] : TotalsPerThread(report))
+		{
+			output << "  thread " << std::left << std::setw(8) << thread << std::right << std::setw(8) << totals.blocks << " blocks "
+				<< std::setw(12) << totals.seconds * 1e3 << " ms " << std::setw(10)
+				<< (totals.seconds > 0 ? totals.inputSize / totals.seconds / 1e6 : 0.0) << " MB/s" << std::endl;
+		}
+		output << std::defaultfloat;
+	}
+
+	void WriteStatsJson(std::ostream& output, const StatsReport& report, double wallSeconds)
+	{
+		output << "{\n  \"wall_seconds\": " << wallSeconds << ",\n  \"counters\": {";
+		for (std::size_t i = 0; i < kCounterCount; i++)
+		{
+			output << (i ? ", " : " ") << '"' << CounterName(static_cast<Counter>(i)) << "\": " << report.counters[i];
+		}
+		output << " },\n  \"average_code_length\": " << AverageCodeLength(report) << ",\n  \"phases\": {";
+		for (std::size_t i = 0; i < kPhaseCount; i++)
+		{
+			output << (i ? ",\n" : "\n") << "    \"" << PhaseName(static_cast<Phase>(i)) << "\": { \"seconds\": " << report.phaseSeconds[i]
+				<< ", \"calls\": " << report.phaseCalls[i] << " }";
+		}
+		output << "\n  },\n  \"threads\": [";
+
+		bool first = true;
+		for (const auto& [thread, totals] : TotalsPerThread(report))
+		{
+			output << (first ? "\n" : ",\n") << "    { \"thread\": " << thread << ", \"blocks\": " << totals.blocks
+				<< ", \"seconds\": " << totals.seconds << ", \"input_bytes\": " << totals.inputSize << " }";
+			first = false;
+		}
+		output << "\n  ],\n  \"blocks\": [";
+
+		for (std::size_t i = 0; i < report.blocks.size(); i++)
+		{
+			const BlockRecord& block = report.blocks[i];
+			output << (i ? ",\n" : "\n") << "    { \"thread\": " << block.thread << ", \"seconds\": " << block.seconds
+				<< ", \"input_bytes\": " << block.inputSize << ", \"output_bytes\": " << block.outputSize << " }";
+		}
+		output << "\n  ]\n}" << std::endl;
+	}
+}
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "Core.h"
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+namespace Core
+{
+	/**
+	* @brief Whether the instrumentation is compiled in, define PISTONE_NO_STATS to compile it out.
+	*
+	* Compiled in, every timer and counter first checks a relaxed atomic flag, so a disabled
+	* build pays one load per block phase. Compiled out, they are empty inline functions.
+	*/
+#ifdef PISTONE_NO_STATS
+	constexpr bool kStatsCompiled = false;
+#else
+	constexpr bool kStatsCompiled = true;
+#endif
+
+	/**
+	* @brief Phases of a compression job timed by ScopedTimer.
+	*/
+	enum class Phase
+	{
+		ReadInput,
+		Histogram,
+		MatchFinding,
+		CodeLengths,
+		Header,
+		Packing,
+		Unpacking,
+		WriteOutput,
+		Count
+	};
+
+	/**
+	* @brief Quantities of a compression job accumulated by AddCounter and MaxCounter.
+	*/
+	enum class Counter
+	{
+		/**< Bytes read from the input file. */
+		BytesIn,
+		/**< Bytes written to the output file. */
+		BytesOut,
+		/**< Symbols coded by an entropy coder, literal and match symbols for lz77. */
+		Symbols,
+		/**< Bits spent on those symbols, extra bits included. */
+		CodedBits,
+		/**< Longest prefix code used by a block. */
+		MaxCodeLength,
+		/**< Bytes of block headers: sizes, block types and code tables. */
+		HeaderBytes,
+		/**< Blocks kept uncompressed because coding would not shrink them. */
+		StoredBlocks,
+		Count
+	};
+
+	/**
+	* @brief Timing of one block encoded or decoded, recorded by BlockTimer.
+	*/
+	struct BlockRecord
+	{
+		/**< Small number identifying the thread, in order of first use. */
+		unsigned thread;
+
+		double seconds;
+
+		std::size_t inputSize;
+
+		std::size_t outputSize;
+	};
+
+	/**
+	* @brief A copy of everything recorded since the last ResetStats.
+	*/
+	struct StatsReport
+	{
+		double phaseSeconds[static_cast<std::size_t>(Phase::Count)];
+
+		std::uint64_t phaseCalls[static_cast<std::size_t>(Phase::Count)];
+
+		std::uint64_t counters[static_cast<std::size_t>(Counter::Count)];
+
+		std::vector<BlockRecord> blocks;
+	};
+
+	namespace Detail
+	{
+		extern std::atomic<bool> statsEnabled;
+
+		void RecordPhase(Phase phase, std::chrono::steady_clock::duration duration);
+
+		void RecordCounter(Counter counter, std::uint64_t value);
+
+		void RecordMax(Counter counter, std::uint64_t value);
+
+		void RecordBlock(std::chrono::steady_clock::duration duration, std::size_t inputSize, std::size_t outputSize);
+	}
+
+	/**
+	* @brief Returns whether timers and counters currently record.
+	*/
+	inline bool StatsEnabled()
+	{
+		if constexpr (kStatsCompiled) return Detail::statsEnabled.load(std::memory_order_relaxed);
+		else return false;
+	}
+
+	/**
+	* @brief Starts or stops recording, recording is off by default.
+	*/
+	void EnableStats(bool enabled);
+
+	/**
+	* @brief Clears every timer, counter and block record.
+	*/
+	void ResetStats();
+
+	/**
+	* @brief Returns a copy of the recorded statistics.
+	*/
+	StatsReport CollectStats();
+
+	/**
+	* @brief Adds a value to a counter.
+	*/
+	inline void AddCounter(Counter counter, std::uint64_t value)
+	{
+		if (StatsEnabled()) Detail::RecordCounter(counter, value);
+	}
+
+	/**
+	* @brief Raises a counter to a value if it is lower.
+	*/
+	inline void MaxCounter(Counter counter, std::uint64_t value)
+	{
+		if (StatsEnabled()) Detail::RecordMax(counter, value);
+	}
+
+	/**
+	* @brief Adds the time until the end of its scope to a phase.
+	*
+	* Phases are summed over threads, so with several threads they may add up to more than the wall time.
+	*/
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(Phase phase) : phase(phase), running(StatsEnabled())
+		{
+			if (running) start = std::chrono::steady_clock::now();
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+		~ScopedTimer()
+		{
+			stop();
+		}
+
+		/**
+		* @brief Ends the phase before the end of the scope.
+		*/
+		void stop()
+		{
+			if (running) Detail::RecordPhase(phase, std::chrono::steady_clock::now() - start);
+			running = false;
+		}
+
+	private:
+		Phase phase;
+
+		bool running;
+
+		std::chrono::steady_clock::time_point start;
+	};
+
+	/**
+	* @brief Records the duration and sizes of one encoded or decoded block.
+	*/
+	class BlockTimer
+	{
+	public:
+		explicit BlockTimer(std::size_t inputSize) : inputSize(inputSize), running(StatsEnabled())
+		{
+			if (running) start = std::chrono::steady_clock::now();
+		}
+
+		BlockTimer(const BlockTimer&) = delete;
+
+		BlockTimer& operator=(const BlockTimer&) = delete;
+
+		/**
+		* @brief Records the block, a block whose coding threw is not recorded.
+		*/
+		void stop(std::size_t outputSize)
+		{
+			if (running) Detail::RecordBlock(std::chrono::steady_clock::now() - start, inputSize, outputSize);
+			running = false;
+		}
+
+	private:
+		std::size_t inputSize;
+
+		bool running;
+
+		std::chrono::steady_clock::time_point start;
+	};
+
+	/**
+	* @brief Returns the name of a phase, as used in the reports.
+	*/
+	const char* PhaseName(Phase phase);
+
+	/**
+	* @brief Returns the name of a counter, as used in the reports.
+	*/
+	const char* CounterName(Counter counter);
+
+	/**
+	* @brief Writes a human-readable summary: sizes, code lengths, phase times and block times per thread.
+	*
+	* @param output The stream to write to.
+	* @param report The statistics to summarize.
+	* @param wallSeconds Duration of the whole job.
+	*/
+	void WriteStatsSummary(std::ostream& output, const StatsReport& report, double wallSeconds);
+
+	/**
+	* @brief Writes the statistics as one JSON object, with every block record.
+	*
+	* @param output The stream to write to.
+	* @param report The statistics to write.
+	* @param wallSeconds Duration of the whole job.
+	*/
+	void WriteStatsJson(std::ostream& output, const StatsReport& report, double wallSeconds);
+}
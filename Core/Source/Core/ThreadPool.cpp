@@ -0,0 +1,118 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace Core
+{
+	ThreadPool::ThreadPool(unsigned threadCount)
+	{
+		if (threadCount == 0) threadCount = 1;
+
+		workers.reserve(threadCount);
+		for (unsigned i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			tasksFinished.wait(lock, [this] { return pendingTasks == 0; });
+			stopping = true;
+		}
+		taskAvailable.notify_all();
+
+		for (std::thread& worker : workers) worker.join();
+	}
+
+	void ThreadPool::submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push(std::move(task));
+			++pendingTasks;
+		}
+		taskAvailable.notify_one();
+	}
+
+	void ThreadPool::wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		tasksFinished.wait(lock, [this] { return pendingTasks == 0; });
+
+		if (firstError)
+		{
+			std::exception_ptr error = firstError;
+			firstError = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+
+	void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body)
+	{
+		std::atomic<std::size_t> nextIndex = 0;
+		std::atomic<bool> failed = false;
+
+		std::size_t taskCount = std::min<std::size_t>(count, workers.size());
+		for (std::size_t t = 0; t < taskCount; t++)
+		{
+			submit([&]
+			{
+				for (std::size_t index = nextIndex++; index < count && !failed; index = nextIndex++)
+				{
+					try
+					{
+						body(index);
+					}
+					catch (...)
+					{
+						failed = true;
+						throw;
+					}
+				}
+			});
+		}
+
+		wait();
+	}
+
+	unsigned ThreadPool::hardwareThreads()
+	{
+		unsigned count = std::thread::hardware_concurrency();
+		return count == 0 ? 1 : count;
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (tasks.empty()) return;
+
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+
+			try
+			{
+				task();
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!firstError) firstError = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--pendingTasks == 0) tasksFinished.notify_all();
+			}
+		}
+	}
+}
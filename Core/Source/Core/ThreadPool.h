@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+	/**
+	* @brief A fixed-size pool of worker threads executing submitted tasks.
+	*/
+	class ThreadPool
+	{
+	public:
+		/**
+		* @brief Starts threadCount worker threads (at least one).
+		*/
+		explicit ThreadPool(unsigned threadCount);
+
+		ThreadPool(const ThreadPool&) = delete;
+
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/**
+		* @brief Waits for the queued tasks and joins the workers.
+		*/
+		~ThreadPool();
+
+		/**
+		* @brief Queues a task for execution on one of the workers.
+		*/
+		void submit(std::function<void()> task);
+
+		/**
+		* @brief Blocks until every submitted task has finished.
+		*
+		* @throw The first exception thrown by a task since the last wait.
+		*/
+		void wait();
+
+		/**
+		* @brief Runs body(index) for every index in [0, count) on the workers and waits for them.
+		*
+		* Indices are handed out dynamically, so uneven work per index still balances.
+		*
+		* @throw The first exception thrown by body.
+		*/
+		void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+		/**
+		* @brief Returns the number of worker threads.
+		*/
+		unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+		/**
+		* @brief Returns the number of hardware threads, at least 1.
+		*/
+		static unsigned hardwareThreads();
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> workers;
+
+		std::queue<std::function<void()>> tasks;
+
+		std::mutex mutex;
+
+		std::condition_variable taskAvailable;
+
+		std::condition_variable tasksFinished;
+
+		std::size_t pendingTasks = 0;
+
+		bool stopping = false;
+
+		std::exception_ptr firstError;
+	};
+}
@@ -1,8 +1,98 @@
 #include "App.h"
 #include "Core/Core.h"
 #include "Core/Huffman.h"
+#include "Core/LZ77.h"
+#include "Core/ANS.h"
+#include "Core/Registry.h"
+#include "Core/Archive.h"
+#include "Core/ThreadPool.h"
+#include "Core/MappedFile.h"
+#include "Core/Stats.h"
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <string>
 
+static std::uintmax_t PathSize(const String& path)
+{
+	std::error_code error;
+	if (fs::is_regular_file(path, error)) return fs::file_size(path, error);
+
+	std::uintmax_t size = 0;
+	if (fs::is_directory(path, error))
+	{
+		for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path, error))
+		{
+			if (entry.is_regular_file()) size += entry.file_size();
+		}
+	}
+	return size;
+}
+
+static void ListArchive(const std::vector<Core::ArchiveEntry>& entries)
+{
+	std::cout << std::setw(14) << "size" << std::setw(14) << "encoded" << std::setw(10) << "crc32" << "  path\n";
+	for (const Core::ArchiveEntry& entry : entries)
+	{
+		if (entry.type == Core::EntryType::Directory)
+		{
+			std::cout << std::setw(14) << "-" << std::setw(14) << "-" << std::setw(10) << "-" << "  " << entry.path << "/\n";
+			continue;
+		}
+		std::cout << std::setw(14) << entry.size;
+		if (entry.type == Core::EntryType::Duplicate) std::cout << std::setw(14) << "duplicate";
+		else std::cout << std::setw(14) << entry.encodedSize;
+		std::cout << "  " << std::hex << std::setfill('0') << std::setw(8)
+			<< entry.checksum << std::dec << std::setfill(' ') << "  " << entry.path << '\n';
+	}
+	std::cout << std::flush;
+}
+
+static Huffman::SharedTable TrainTable(const String& corpusPath, int maxCodeLength)
+{
+	std::uint64_t counts[Huffman::kAlphabetSize] = {};
+	auto countFile = [&](const String& filePath)
+	{
+		Core::MappedFile file(filePath);
+		std::uint64_t fileCounts[Huffman::kAlphabetSize];
+		Core::CountBytes(reinterpret_cast<const std::uint8_t*>(file.data()), file.size(), fileCounts);
+		for (std::size_t symbol = 0; symbol < Huffman::kAlphabetSize; symbol++) counts[symbol] += fileCounts[symbol];
+	};
+
+	std::error_code error;
+	if (fs::is_directory(corpusPath, error))
+	{
+		fs::recursive_directory_iterator iterator(corpusPath, error);
+		for (; !error && iterator != fs::recursive_directory_iterator(); iterator.increment(error))
+		{
+			fs::file_status status = iterator->status(error);
+			// A dangling link is skipped like any other entry that is not a file.
+			if (status.type() == fs::file_type::not_found) error.clear();
+			if (error) throw Core::CompressionException("Error loading: " + iterator->path().string());
+			if (fs::is_regular_file(status)) countFile(iterator->path().string());
+		}
+		if (error) throw Core::CompressionException("Error loading: " + corpusPath);
+	}
+	else
+	{
+		countFile(corpusPath);
+	}
+	return Huffman::TrainSharedTable(counts, maxCodeLength);
+}
+
+static void PrintStats(const String& format, const String& inFilePath, const String& outFilePath, std::chrono::steady_clock::time_point start)
+{
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	Core::AddCounter(Core::Counter::BytesIn, PathSize(inFilePath));
+	Core::AddCounter(Core::Counter::BytesOut, PathSize(outFilePath));
+
+	Core::StatsReport report = Core::CollectStats();
+	if (format == "json") Core::WriteStatsJson(std::cout, report, wallSeconds);
+	else Core::WriteStatsSummary(std::cout, report, wallSeconds);
+}
 
 int main(int argc, char* argv[])
 {
@@ -10,7 +100,26 @@ int main(int argc, char* argv[])
 	String outFilePath = "";
 	bool encodingMode = true;
 	bool isDirectory = false;
+	unsigned threadCount = 1;
+	std::size_t blockSize = Core::kDefaultBlockSize;
+	bool decodeRange = false;
+	std::size_t rangeOffset = 0;
+	std::size_t rangeLength = 0;
+	std::size_t memoryBudget = Core::kDefaultMemoryBudget;
+	int maxCodeLength = Huffman::kDefaultCodeLengthLimit;
+	std::string methodName = "";
+	double minEncodeSpeed = Core::kDefaultMinEncodeSpeed;
+	int windowLog = LZ77::kDefaultWindowLog;
+	unsigned searchDepth = LZ77::kDefaultSearchDepth;
 	std::unique_ptr<Core::CompressionMethod> compressionMethod;
+	String statsFormat = "";
+	bool listArchive = false;
+	bool preallocate = false;
+	bool hardLink = false;
+	String previousArchivePath = "";
+	String extractPath = "";
+	String tablePath = "";
+	bool trainTable = false;
 
 	if (argc <= 1)
 	{
@@ -43,10 +152,106 @@ int main(int argc, char* argv[])
 						encodingMode = true;
 						break;
 
+				case 't':
+					if (i < argc - 1)
+					{
+						threadCount = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+						if (threadCount == 0) threadCount = Core::ThreadPool::hardwareThreads();
+					}
+					break;
+
+				case 'b':
+					if (i < argc - 1)
+					{
+						blockSize = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10)) * 1024;
+						if (blockSize == 0) blockSize = Core::kDefaultBlockSize;
+					}
+					break;
+
 				case 'f':
 						isDirectory = true;
 						break;
 
+				case 'M':
+					if (i < argc - 1)
+					{
+						memoryBudget = static_cast<std::size_t>(std::strtoull(argv[++i], nullptr, 10)) << 20;
+						if (memoryBudget == 0) memoryBudget = Core::kDefaultMemoryBudget;
+					}
+					break;
+
+				case 'L':
+					if (i < argc - 1)
+					{
+						maxCodeLength = std::atoi(argv[++i]);
+						if (maxCodeLength < Huffman::kMinCodeLengthLimit || maxCodeLength > Huffman::kMaxCodeLengthLimit)
+						{
+							std::cout << "Invalid code length limit, expected 8 to 15." << std::endl;
+							return 1;
+						}
+					}
+					break;
+
+				case 'w':
+					if (i < argc - 1)
+					{
+						windowLog = std::atoi(argv[++i]);
+						if (windowLog < LZ77::kMinWindowLog || windowLog > LZ77::kMaxWindowLog)
+						{
+							std::cout << "Invalid window size, expected 10 to 24." << std::endl;
+							return 1;
+						}
+					}
+					break;
+
+				case 's':
+					if (i < argc - 1)
+					{
+						searchDepth = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+						if (searchDepth == 0) searchDepth = LZ77::kDefaultSearchDepth;
+					}
+					break;
+
+				case 'a':
+					if (i < argc - 1)
+					{
+						minEncodeSpeed = std::strtod(argv[++i], nullptr);
+					}
+					break;
+
+				case 'r':
+					if (i < argc - 1)
+					{
+						char* separator = nullptr;
+						rangeOffset = static_cast<std::size_t>(std::strtoull(argv[++i], &separator, 10));
+						if (*separator != ':')
+						{
+							std::cout << "Invalid range, expected <offset>:<length>." << std::endl;
+							return 1;
+						}
+						rangeLength = static_cast<std::size_t>(std::strtoull(separator + 1, nullptr, 10));
+						decodeRange = true;
+					}
+					break;
+
+				case 'u':
+					if (i < argc - 1)
+					{
+						previousArchivePath = argv[++i];
+					}
+					break;
+
+				case 'l':
+						listArchive = true;
+						break;
+
+				case 'x':
+					if (i < argc - 1)
+					{
+						extractPath = argv[++i];
+					}
+					break;
+
 				case 'D':
 						encodingMode = false;
 						break;
@@ -56,13 +261,11 @@ int main(int argc, char* argv[])
 					{
 						if (i < argc - 1)
 						{
-							if (strcmp(argv[i], "huf") == 0)
-							{
-								Huffman::HuffmanCompression huf = Huffman::HuffmanCompression();
-								compressionMethod = std::make_unique<Huffman::HuffmanCompression>(huf);
-							}
+							methodName = argv[++i];
 						}
+						break;
 					}
+					[[fallthrough]];
 				case 'h':
 					if (strcmp(argv[i], "-man") == 0 ||
 						strcmp(argv[i], "-h") == 0   ||
@@ -73,6 +276,33 @@ int main(int argc, char* argv[])
 					}
 					break;
 
+				case '-':
+					if (strcmp(argv[i], "--stats") == 0)
+					{
+						statsFormat = "text";
+					}
+					else if (strcmp(argv[i], "--stats=json") == 0)
+					{
+						statsFormat = "json";
+					}
+					else if (strcmp(argv[i], "--preallocate") == 0)
+					{
+						preallocate = true;
+					}
+					else if (strcmp(argv[i], "--hardlink") == 0)
+					{
+						hardLink = true;
+					}
+					else if (strcmp(argv[i], "--train") == 0)
+					{
+						trainTable = true;
+					}
+					else if (strcmp(argv[i], "--table") == 0 && i < argc - 1)
+					{
+						tablePath = argv[++i];
+					}
+					break;
+
 				default:
 					break;
 			}
@@ -81,6 +311,67 @@ int main(int argc, char* argv[])
 
 	}
 
+	Core::MethodOptions options;
+	options.blockSize = blockSize;
+	options.threadCount = threadCount;
+	options.memoryBudget = memoryBudget;
+	options.maxCodeLength = maxCodeLength;
+	options.windowLog = windowLog;
+	options.searchDepth = searchDepth;
+	if (methodName != "" && methodName != "auto" && !Core::FindMethod(methodName))
+	{
+		std::cout << "Unknown compression method: " << methodName << std::endl;
+		return 1;
+	}
+
+	std::vector<char> table;
+	if (tablePath != "")
+	{
+		try
+		{
+			Core::MappedFile tableFile(tablePath);
+			options.sharedTable = std::make_shared<const Huffman::SharedTable>(Huffman::ReadSharedTable(tableFile.view()));
+			Huffman::WriteSharedTable(*options.sharedTable, table);
+		}
+		catch (const Core::CompressionException& error)
+		{
+			std::cout << error.what() << std::endl;
+			return 1;
+		}
+	}
+
+	// Streams name the method that wrote them, a method given for decoding must match it.
+	auto decodingMethod = [&](std::uint8_t firstByte) -> const Core::MethodInfo&
+	{
+		const Core::MethodInfo& method = Core::DetectMethod(firstByte);
+		if (methodName != "" && methodName != "auto" && methodName != method.name)
+		{
+			throw Core::CompressionException("Input was compressed with " + method.name + ", not " + methodName);
+		}
+		return method;
+	};
+	auto createDecodingMethod = [&](std::uint8_t firstByte)
+	{
+		compressionMethod = decodingMethod(firstByte).create(options);
+	};
+
+	// Folder archives compress files in parallel, each file on one thread.
+	Core::MethodOptions entryOptions = options;
+	entryOptions.threadCount = 1;
+	Core::ExtractOptions extractOptions{ threadCount, preallocate, hardLink };
+	Core::EntryDecoder decodeEntry = [&](std::span<const char> encodedData, std::vector<char>& data)
+	{
+		decodingMethod(static_cast<std::uint8_t>(encodedData[0])).create(entryOptions)->decode(encodedData, data);
+	};
+
+	// Archives carry the table their entries were encoded with.
+	auto useArchiveTable = [&](const Core::MappedFile& archive)
+	{
+		std::span<const char> dictionary = Core::ReadArchiveDictionary(archive.data(), archive.size());
+		if (!dictionary.empty()) entryOptions.sharedTable = std::make_shared<const Huffman::SharedTable>(Huffman::ReadSharedTable(dictionary));
+		return dictionary;
+	};
+
 	if (inFilePath == "")
 	{
 		std::cout << "No file path provided." << std::endl;
@@ -88,27 +379,171 @@ int main(int argc, char* argv[])
 	}
 	else
 	{
+		auto start = std::chrono::steady_clock::now();
+		Core::EnableStats(statsFormat != "");
+
+		if (trainTable)
+		{
+			try
+			{
+				table.clear();
+				Huffman::WriteSharedTable(TrainTable(inFilePath, maxCodeLength), table);
+				Core::WriteFile(outFilePath, table);
+			}
+			catch (const Core::CompressionException& error)
+			{
+				std::cout << error.what() << std::endl;
+				return 1;
+			}
+			return 0;
+		}
+
+		if (listArchive || extractPath != "")
+		{
+			try
+			{
+				// Only the directory and the extracted entries are read from the mapping.
+				Core::MappedFile archive(inFilePath, Core::AccessHint::Random);
+				std::vector<Core::ArchiveEntry> entries = Core::ReadArchiveDirectory(archive.data(), archive.size());
+				if (listArchive)
+				{
+					ListArchive(entries);
+					return 0;
+				}
+				useArchiveTable(archive);
+
+				const Core::ArchiveEntry* entry = Core::FindEntry(entries, extractPath);
+				if (!entry) throw Core::CompressionException("No such entry in archive: " + extractPath);
+
+				if (entry->type == Core::EntryType::Directory)
+				{
+					Core::DecodeFolder(archive.data(), archive.size(), outFilePath, extractOptions, decodeEntry, extractPath);
+				}
+				else
+				{
+					std::vector<char> data = Core::DecodeEntry(archive.data(), *entry, decodeEntry);
+
+					Core::ScopedTimer writeTimer(Core::Phase::WriteOutput);
+					Core::WriteFile(outFilePath, data, preallocate);
+				}
+			}
+			catch (const Core::CompressionException& error)
+			{
+				std::cout << error.what() << std::endl;
+				return 1;
+			}
+			if (statsFormat != "") PrintStats(statsFormat, inFilePath, outFilePath, start);
+			return 0;
+		}
+
 		if (encodingMode)
 		{		
 			try 
 			{
-				std::shared_ptr<char> data;
-				std::size_t size;
 				if (isDirectory)
 				{
-					Core::ReadFolder(inFilePath, data, size);
+					// Updating an archive in place writes the new one next to it and replaces it at the end.
+					std::unique_ptr<Core::MappedFile> previousArchive;
+					String archivePath = outFilePath;
+					if (previousArchivePath != "")
+					{
+						previousArchive = std::make_unique<Core::MappedFile>(previousArchivePath, Core::AccessHint::Random);
+						std::error_code error;
+						if (fs::equivalent(previousArchivePath, outFilePath, error)) archivePath = outFilePath + ".tmp";
+
+						// Without a new table the update keeps the previous one, so its files stay reusable.
+						if (tablePath == "")
+						{
+							std::span<const char> dictionary = useArchiveTable(*previousArchive);
+							table.assign(dictionary.begin(), dictionary.end());
+						}
+					}
+
+					// With -m auto every file gets the method suiting it best.
+					if (methodName != "auto") compressionMethod = Core::FindMethod(methodName == "" ? "huf" : methodName)->create(entryOptions);
+
+					try
+					{
+						Core::StreamFile(archivePath, [&](std::ostream& output)
+						{
+							Core::EncodeFolder(inFilePath, output, threadCount, memoryBudget, [&](std::span<const char> data, std::vector<char>& encodedData)
+							{
+								if (compressionMethod) compressionMethod->encode(data, encodedData);
+								else Core::SelectMethod(data, entryOptions, minEncodeSpeed).create(entryOptions)->encode(data, encodedData);
+							}, previousArchive ? previousArchive->view() : std::span<const char>(), table);
+						});
+					}
+					catch (...)
+					{
+						// A failed in-place update leaves the previous archive as it was.
+						std::error_code error;
+						if (archivePath != outFilePath) fs::remove(archivePath, error);
+						throw;
+					}
+
+					if (archivePath != outFilePath)
+					{
+						previousArchive.reset();
+						std::error_code error;
+						fs::rename(archivePath, outFilePath, error);
+						if (error)
+						{
+							fs::remove(archivePath, error);
+							throw Core::CompressionException("Error replacing archive: " + outFilePath);
+						}
+					}
+					if (statsFormat != "") PrintStats(statsFormat, inFilePath, outFilePath, start);
+					return 0;
 				}
-				else
+
+				std::shared_ptr<char> data;
+				std::size_t size = 0;
+				std::unique_ptr<Core::MappedFile> input;
+
+				Core::ScopedTimer readTimer(Core::Phase::ReadInput);
+				if (fs::is_regular_file(inFilePath))
+				{
+					input = std::make_unique<Core::MappedFile>(inFilePath);
+				}
+				readTimer.stop();
+
+				std::span<const char> sample = input ? input->view() : std::span<const char>();
+				const Core::MethodInfo* method = methodName == "auto" ? &Core::SelectMethod(sample, options, minEncodeSpeed)
+					: Core::FindMethod(methodName == "" ? "huf" : methodName);
+				compressionMethod = method->create(options);
+
+				auto* streamMethod = dynamic_cast<Core::StreamCompressionMethod*>(compressionMethod.get());
+				if (streamMethod)
+				{
+					if (input)
+					{
+						Core::StreamFile(outFilePath, [&](std::ostream& output)
+						{
+							streamMethod->encodeStream(input->view(), output);
+						});
+					}
+					else
+					{
+						Core::StreamFile(inFilePath, outFilePath, [&](std::istream& input, std::ostream& output)
+						{
+							streamMethod->encodeStream(input, output);
+						});
+					}
+					if (statsFormat != "") PrintStats(statsFormat, inFilePath, outFilePath, start);
+					return 0;
+				}
+
+				std::span<const char> toEncode = input ? input->view() : std::span<const char>();
+				if (!input)
 				{
 					Core::ReadFile(inFilePath, data, size);
+					toEncode = std::span<const char>(data.get(), size);
 				}
-				
-				
-				//Guessing the sufficient length of the vector
-				std::vector<std::bitset<8>> encodedData;
-				encodedData.reserve(round(size * 0.9));
 
-				compressionMethod->encode(data, size, encodedData);
+				std::vector<char> encodedData;
+				compressionMethod->encode(toEncode, encodedData);
+
+				Core::ScopedTimer writeTimer(Core::Phase::WriteOutput);
 				Core::WriteFile(outFilePath, encodedData);
 			}
 			catch (const Core::CompressionException& error)
@@ -121,21 +556,65 @@ int main(int argc, char* argv[])
 		{
 			try
 			{
-				std::vector<std::bitset<8>> dataToDecodede;
-				Core::ReadFile(inFilePath, dataToDecodede);
+				if (!isDirectory && !decodeRange && !fs::is_regular_file(inFilePath))
+				{
+					Core::StreamFile(inFilePath, outFilePath, [&](std::istream& input, std::ostream& output)
+					{
+						int firstByte = input.peek();
+						if (firstByte == std::char_traits<char>::eof()) throw Core::CompressionException("Invalid data format");
+						createDecodingMethod(static_cast<std::uint8_t>(firstByte));
+
+						auto* streamMethod = dynamic_cast<Core::StreamCompressionMethod*>(compressionMethod.get());
+						if (!streamMethod) throw Core::CompressionException("The method cannot decode streams");
+						streamMethod->decodeStream(input, output);
+					});
+					if (statsFormat != "") PrintStats(statsFormat, inFilePath, outFilePath, start);
+					return 0;
+				}
+
+				Core::MappedFile dataToDecodede(inFilePath, decodeRange ? Core::AccessHint::Random : Core::AccessHint::Sequential);
+				if (dataToDecodede.size() == 0) throw Core::CompressionException("Invalid data format");
+
+				if (isDirectory && Core::IsArchive(dataToDecodede.view()))
+				{
+					useArchiveTable(dataToDecodede);
+					Core::DecodeFolder(dataToDecodede.data(), dataToDecodede.size(), outFilePath, extractOptions, decodeEntry);
+					if (statsFormat != "") PrintStats(statsFormat, inFilePath, outFilePath, start);
+					return 0;
+				}
+
+				createDecodingMethod(static_cast<std::uint8_t>(dataToDecodede.data()[0]));
+
+				auto* streamMethod = dynamic_cast<Core::StreamCompressionMethod*>(compressionMethod.get());
+				if (!isDirectory && !decodeRange && streamMethod)
+				{
+					Core::StreamFile(outFilePath, [&](std::ostream& output)
+					{
+						streamMethod->decodeStream(dataToDecodede.view(), output);
+					});
+					if (statsFormat != "") PrintStats(statsFormat, inFilePath, outFilePath, start);
+					return 0;
+				}
  
 				std::vector<char> data;
-				data.reserve(dataToDecodede.size() * 4);
 
-				compressionMethod->decode(dataToDecodede, data);
+				if (decodeRange && !isDirectory)
+				{
+					compressionMethod->decodeRange(dataToDecodede.view(), rangeOffset, rangeLength, data);
+				}
+				else
+				{
+					compressionMethod->decode(dataToDecodede.view(), data);
+				}
 
+				Core::ScopedTimer writeTimer(Core::Phase::WriteOutput);
 				if (isDirectory)
 				{
-					Core::WriteFolder(outFilePath, data);
+					Core::WriteFolder(outFilePath, data, threadCount, preallocate);
 				}
 				else
 				{
-					Core::WriteFile(outFilePath, data);
+					Core::WriteFile(outFilePath, data, preallocate);
 				}
 			}
 			catch (const Core::CompressionException& error)
@@ -143,7 +622,9 @@ int main(int argc, char* argv[])
 				std::cout << error.what() << std::endl;
 				return 1;
 			}
-		}		
+		}
+
+		if (statsFormat != "") PrintStats(statsFormat, inFilePath, outFilePath, start);
 	}
 	return 0;
-}
\ No newline at end of file
+}
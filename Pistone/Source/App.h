@@ -1,6 +1,22 @@
 #define PRINT_HELP std::cout << "-i <input_path>" << std::endl;\
 std::cout << "-o <output_path>" << std::endl;\
-std::cout << "-m compresion method: (deflaut)\"huf\", \"qoi\"" << std::endl;\
+std::cout << "-m compresion method: (deflaut)\"huf\", \"lz77\", \"ans\", \"auto\" picks one from samples of the input; decoding detects it" << std::endl;\
+std::cout << "-a <speed> slowest encoding -m auto accepts in MB/s, 0 picks the best ratio (default 10)" << std::endl;\
 std::cout << "-f compress folder" << std::endl;\
+std::cout << "-t <threads> number of compression threads, 0 uses all cores (default 1)" << std::endl;\
+std::cout << "-b <block_size> block size in KiB for multithreaded compression (default 1024)" << std::endl;\
+std::cout << "-M <budget> memory budget in MiB for streaming file compression (default 256)" << std::endl;\
+std::cout << "-L <bits> longest Huffman code length, 8 to 15 (default 11)" << std::endl;\
+std::cout << "-w <window_log> lz77 window size as a power of two, 10 to 24 (default 20)" << std::endl;\
+std::cout << "-s <depth> lz77 match candidates searched per position (default 32)" << std::endl;\
+std::cout << "-r <offset>:<length> decode only a byte range of the original file" << std::endl;\
+std::cout << "-u <archive> with -f, copy unchanged files from an earlier archive of the folder and compress only the changed ones" << std::endl;\
+std::cout << "-x <path> extract one file or folder of a folder archive" << std::endl;\
+std::cout << "-l list the entries of a folder archive" << std::endl;\
 std::cout << "-D decoding mode" << std::endl;\
+std::cout << "--preallocate reserve the space of every extracted file before writing it" << std::endl;\
+std::cout << "--hardlink extract files stored once in a folder archive as hard links to one copy" << std::endl;\
+std::cout << "--train train a shared Huffman table on the input file or folder and write it to the output path" << std::endl;\
+std::cout << "--table <table> code small files with a trained Huffman table, needed again for decoding; folder archives store it" << std::endl;\
+std::cout << "--stats print phase timings, sizes and code lengths after the job, --stats=json prints them as JSON" << std::endl;\
 std::cout << "-E encoding mode" << std::endl
\ No newline at end of file
@@ -0,0 +1,95 @@
+#!/bin/bash
+# Round-trips folder archives through updates with -u and checks every extraction
+# against the source tree: files copied by size and time, by size and checksum,
+# duplicates whose target changed and duplicates of files copied from the old archive.
+#
+# Usage: ./Test-Archive.sh [path to Pistone] [threads]
+
+pushd .. > /dev/null
+PISTONE=$(realpath "${1:-Binaries/linux-x86_64/Release/Pistone/Pistone}")
+THREADS=${2:-4}
+popd > /dev/null
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+SOURCE="$WORK/source"
+FAILED=0
+
+check()
+{
+	local archive=$1 name=$2 output="$WORK/out-$2"
+	shift 2
+	if ! "$PISTONE" -D -f -t "$THREADS" -i "$archive" -o "$output" "$@" > "$WORK/log" \
+		|| ! diff -r "$SOURCE" "$output" >> "$WORK/log"; then
+		echo "FAILED: $name"
+		cat "$WORK/log"
+		FAILED=1
+	else
+		echo "ok: $name"
+	fi
+}
+
+update()
+{
+	local previous=$1 archive=$2
+	"$PISTONE" -f -t "$THREADS" -i "$SOURCE" -u "$previous" -o "$archive" || { echo "FAILED: update to $archive"; exit 1; }
+}
+
+# Fixed times, so a change of contents is never hidden by a timestamp of the same second.
+stamp()
+{
+	touch -d "2024-01-01 00:00:$1" "${@:2}"
+}
+
+mkdir -p "$SOURCE/docs/old" "$SOURCE/data" "$SOURCE/empty"
+for i in $(seq 1 40); do echo "line $i of the shared text" >> "$SOURCE/docs/a.txt"; done
+cp "$SOURCE/docs/a.txt" "$SOURCE/docs/old/a-copy.txt"
+cp "$SOURCE/docs/a.txt" "$SOURCE/data/a-copy.txt"
+seq 1 5000 > "$SOURCE/data/numbers.txt"
+cp "$SOURCE/data/numbers.txt" "$SOURCE/docs/numbers-copy.txt"
+echo "touched" > "$SOURCE/data/touched.txt"
+head -c 100000 /dev/urandom > "$SOURCE/data/random.bin"
+: > "$SOURCE/data/blank.txt"
+stamp 01 $(find "$SOURCE" -type f)
+
+"$PISTONE" -f -t "$THREADS" -i "$SOURCE" -o "$WORK/v1.hcd" || { echo "FAILED: archive"; exit 1; }
+check "$WORK/v1.hcd" "archive"
+
+# The target of two duplicates changes, one of them is extracted from its old contents.
+echo "edited" >> "$SOURCE/docs/a.txt"
+stamp 02 "$SOURCE/docs/a.txt"
+# Same size and contents with a new time: copied by checksum.
+stamp 03 "$SOURCE/data/touched.txt"
+# Same size, new contents and time: compressed again.
+head -c 100000 /dev/urandom > "$SOURCE/data/random.bin"
+stamp 04 "$SOURCE/data/random.bin"
+# New files: a duplicate of a copied file and one of a changed file.
+cp "$SOURCE/data/numbers.txt" "$SOURCE/numbers-new.txt"
+cp "$SOURCE/docs/a.txt" "$SOURCE/a-new.txt"
+stamp 05 "$SOURCE/numbers-new.txt" "$SOURCE/a-new.txt"
+update "$WORK/v1.hcd" "$WORK/v2.hcd"
+check "$WORK/v2.hcd" "update"
+check "$WORK/v2.hcd" "update, hard links" --hardlink
+
+# The duplicates now take the edited contents, the file they duplicated is removed.
+cp "$SOURCE/docs/a.txt" "$SOURCE/docs/old/a-copy.txt"
+rm "$SOURCE/data/a-copy.txt" "$SOURCE/data/numbers.txt"
+stamp 06 "$SOURCE/docs/old/a-copy.txt"
+update "$WORK/v2.hcd" "$WORK/v3.hcd"
+check "$WORK/v3.hcd" "second update"
+
+# Updating an archive in place.
+cp "$WORK/v3.hcd" "$WORK/in-place.hcd"
+echo "in place" > "$SOURCE/data/touched.txt"
+stamp 07 "$SOURCE/data/touched.txt"
+update "$WORK/in-place.hcd" "$WORK/in-place.hcd"
+check "$WORK/in-place.hcd" "update in place"
+
+# A fresh archive of the final tree stores no more than the updated one.
+"$PISTONE" -f -t "$THREADS" -i "$SOURCE" -o "$WORK/fresh.hcd" || { echo "FAILED: fresh archive"; exit 1; }
+if [ "$(stat -c %s "$WORK/in-place.hcd")" -gt "$(stat -c %s "$WORK/fresh.hcd")" ]; then
+	echo "FAILED: the updated archive is larger than a fresh one"
+	FAILED=1
+fi
+
+exit $FAILED